@@ -57,6 +57,12 @@ typedef int (*xlivebg_start_func)(long, void*);
 typedef void (*xlivebg_stop_func)(void*);
 typedef void (*xlivebg_draw_func)(long, void*);
 typedef void (*xlivebg_prop_func)(const char*, void*);
+typedef void (*xlivebg_suspend_func)(int, void*);
+typedef void (*xlivebg_fd_func)(int, void*);
+typedef void (*xlivebg_draw_screen_func)(int, long, void*);
+typedef void (*xlivebg_quality_func)(int, void*);
+typedef void (*xlivebg_draw_sw_func)(uint32_t*, int, int, int, long, void*);
+typedef void (*xlivebg_tile_func)(uint32_t*, int, int, int, int, int, void*);
 
 struct xlivebg_image {
 	int width, height;
@@ -91,12 +97,49 @@ struct xlivebg_plugin {
 	xlivebg_prop_func prop;		/* called when a property in props has changed (optional) */
 
 	void *data, *so;
+
+	/* called with 1 when drawing is suspended because nothing is visible, and
+	 * with 0 when it's resumed (optional). Plugins may use it to release any
+	 * per-frame resources while suspended. The time passed to draw does not
+	 * advance while suspended.
+	 */
+	xlivebg_suspend_func suspend;
+
+	/* called to draw a single screen, instead of draw (optional). The viewport
+	 * and scissor rectangle are set to the screen before it's called. Screens
+	 * may be updated at different rates (see the output sections of the config
+	 * file), and those not due for an update are skipped when possible.
+	 */
+	xlivebg_draw_screen_func draw_screen;
+
+	/* called when the adaptive quality level changes (optional). Plugins with
+	 * a quality callback should declare how many quality levels they support
+	 * in their property list (quality_levels = N). xlivebg then steps the
+	 * level between 0 (fastest) and N-1 (best looking) to keep the frame time
+	 * within the configured budget.
+	 */
+	xlivebg_quality_func quality;
+
+	/* called to draw every frame with the software renderer (optional), with
+	 * the framebuffer pixels (0xXXRRGGBB), its stride in pixels, width and
+	 * height (the size of the root window), and the time in milliseconds.
+	 * Only plugins which provide it can be used when xlivebg runs without
+	 * OpenGL (see xlivebg_software).
+	 */
+	xlivebg_draw_sw_func draw_sw;
 };
 
 /* Needs to be called by the plugin's register_plugin function, to provide the
- * xlivebg_plugin structure to the live wallpaper system.
+ * xlivebg_plugin structure to the live wallpaper system. size is the size of
+ * the structure the plugin was built with, which xlivebg_register_plugin
+ * passes automatically. New members are only ever appended, and plugins built
+ * against an older, smaller structure keep working: they're copied into a
+ * structure of the current size, with the missing members set to null.
+ * Changing the structure of such a plugin after registration has no effect.
  */
+int xlivebg_register_plugin2(struct xlivebg_plugin *plugin, int size);
 int xlivebg_register_plugin(struct xlivebg_plugin *plugin);
+#define xlivebg_register_plugin(p)	xlivebg_register_plugin2((p), sizeof *(p))
 
 int xlivebg_screen_count(void);
 struct xlivebg_screen *xlivebg_screen(int idx);
@@ -113,6 +156,8 @@ struct xlivebg_image *xlivebg_anim_mask(int scr);
  * Supported formats: PNG, JPEG, TGA, PPM/PGM, LBM/PBM, RGBE
  */
 int xlivebg_memory_image(struct xlivebg_image *img, void *data, long datasz);
+/* frees the pixels and texture of an image created by xlivebg_memory_image */
+void xlivebg_destroy_image(struct xlivebg_image *img);
 unsigned int xlivebg_image_texture(struct xlivebg_image *img);
 
 int xlivebg_fit_mode(int scr);
@@ -160,4 +205,79 @@ void xlivebg_gl_image_proj(int scr, float img_aspect);
 
 void xlivebg_mouse_pos(int *mx, int *my);
 
+/* frame timing, computed once per frame by xlivebg, before calling draw.
+ * xlivebg_time_usec returns the animation time of the current frame in
+ * microseconds (the same clock as the msec argument of draw), and
+ * xlivebg_frame_delta the time elapsed since the previous frame in seconds.
+ * xlivebg_frame_count returns the number of frames drawn so far.
+ */
+int64_t xlivebg_time_usec(void);
+float xlivebg_frame_delta(void);
+unsigned long xlivebg_frame_count(void);
+
+/* reports a rectangle of screen scr changed by the current frame, in pixels
+ * relative to the top-left corner of the screen. Must be called from draw,
+ * before drawing. When at least one rectangle is reported, xlivebg restricts
+ * drawing (with the scissor test) to the damaged area, and presents only that
+ * part of the screen, if the GLX implementation allows it. Reporting an empty
+ * rectangle means nothing changed. Frames without any damage reported are
+ * drawn and presented in full. Plugins using it shouldn't touch the scissor
+ * test themselves.
+ */
+void xlivebg_damage(int scr, int x, int y, int width, int height);
+
+/* returns the current adaptive quality level of the plugin. Plugins read it
+ * in start, and then get notified of changes through the quality callback.
+ */
+int xlivebg_quality(void);
+
+/* returns the framebuffer object the plugin is drawing into. When layers are
+ * configured, each one is drawn into its own framebuffer object, and with
+ * render scaling, into a smaller one which is upscaled to the window. Plugins
+ * which render to their own framebuffer objects must bind this one back
+ * afterwards, instead of 0.
+ */
+unsigned int xlivebg_framebuffer(void);
+
+/* declares that the output of the plugin won't change until it says
+ * otherwise (for instance because of its current property values). While
+ * it's static, xlivebg stops drawing and presenting frames, and calls draw
+ * again only when something changes: a property, the outputs, the window, or
+ * when drawing resumes after being suspended. Reset when the plugin is
+ * activated, and ignored for plugins drawn as layers.
+ */
+void xlivebg_set_static(int st);
+
+/* declares that the animation of the plugin repeats exactly every msec
+ * milliseconds (0: not periodic). Once a full period has been drawn, xlivebg
+ * plays the frames back from memory instead of calling draw, until something
+ * changes what the plugin draws. Cached frames are drawn at the time of the
+ * start of their update interval, starting from the default GL state. Reset
+ * when the plugin is activated, and ignored for plugins drawn as layers.
+ */
+void xlivebg_set_period(long msec);
+
+/* returns non-zero when xlivebg draws with the software renderer, calling
+ * draw_sw instead of draw. There's no OpenGL context in that case, so plugins
+ * should check it in start, and skip creating any OpenGL resources.
+ */
+int xlivebg_software(void);
+
+/* splits a width x height rectangle of the software framebuffer, starting at
+ * pixels, into tiles, and calls func for each tile from a pool of worker
+ * threads. func gets a pointer to the first pixel of the tile, the stride in
+ * pixels, the position of the tile relative to the rectangle, its size, and
+ * cls. It must be thread-safe. Returns after all tiles have been drawn.
+ */
+void xlivebg_sw_tiles(uint32_t *pixels, int stride, int width, int height,
+		xlivebg_tile_func func, void *cls);
+
+/* xlivebg_add_fd registers a file descriptor (inotify, eventfd, sockets, etc)
+ * with the xlivebg event loop. func will be called with the file descriptor
+ * and cls, whenever there is input available. Make sure to call
+ * xlivebg_remove_fd before closing the file descriptor.
+ */
+int xlivebg_add_fd(int fd, xlivebg_fd_func func, void *cls);
+void xlivebg_remove_fd(int fd);
+
 #endif	/* XLIVEBG_H_ */
@@ -429,8 +429,9 @@ static char *value_to_str(struct ts_value *value)
 		break;
 
 	default:
-		sprintf(buf, "\"%s\"", value->str);
-		str = append_dynstr(str, buf);
+		DYNARR_STRPUSH(str, '"');
+		str = append_dynstr(str, value->str);
+		DYNARR_STRPUSH(str, '"');
 	}
 
 	return str;
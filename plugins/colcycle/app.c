@@ -55,6 +55,7 @@ struct ss_node {
 
 static void set_image_palette(struct image *img);
 static void show_image(struct image *img, long time_msec);
+static long calc_period(struct image *img);
 static int load_slideshow(const char *path);
 static int load_slide(void);
 
@@ -390,6 +391,58 @@ static void show_image(struct image *img, long time_msec)
 		}
 	}
 	colc_plugin.upd_interval = max_rate * 10;
+
+	/* nothing to animate, unless there's a slideshow to advance */
+	xlivebg_set_static(!max_rate && !sslist);
+	xlivebg_set_period(sslist ? 0 : calc_period(img));
+}
+
+#define MAX_PERIOD	120000
+
+static unsigned long gcd(unsigned long a, unsigned long b)
+{
+	unsigned long tmp;
+
+	while(b) {
+		tmp = a % b;
+		a = b;
+		b = tmp;
+	}
+	return a;
+}
+
+/* the palette repeats when every range has cycled a whole number of times.
+ * A range of rsize colors at some rate moves rate * msec / 280000 colors in
+ * msec milliseconds, so it repeats every multiple of rsize * 280000 / rate
+ * milliseconds (2 * rsize for ping-pong and sine). Returns 0 if the image
+ * isn't animated, or doesn't repeat within MAX_PERIOD.
+ */
+static long calc_period(struct image *img)
+{
+	int i;
+	unsigned long rsize, p, period = 0;
+
+	for(i=0; i<img->num_ranges; i++) {
+		if(!img->range[i].rate) continue;
+
+		rsize = img->range[i].high - img->range[i].low + 1;
+		switch(img->range[i].cmode) {
+		case CYCLE_PINGPONG:
+		case CYCLE_SINE:
+		case CYCLE_SINE_HALF:
+			rsize *= 2;
+			break;
+		default:
+			break;
+		}
+		rsize *= 280000;
+		p = rsize / gcd(rsize, img->range[i].rate);
+
+		if(p > MAX_PERIOD) return 0;
+		period = period ? period / gcd(period, p) * p : p;
+		if(period > MAX_PERIOD) return 0;
+	}
+	return period;
 }
 
 static int load_slideshow(const char *path)
@@ -32,6 +32,8 @@ static int start(long time_msec, void *cls);
 static void stop(void *cls);
 static void draw(long time_msec, void *cls);
 static void draw_screen(int scr_idx, long time_msec);
+static void draw_sw(uint32_t *pixels, int stride, int width, int height, long time_msec, void *cls);
+static void draw_sw_tile(uint32_t *pixels, int stride, int x, int y, int w, int h, void *cls);
 static unsigned int create_program(const char *vsdr, const char *psdr);
 static unsigned int create_shader(unsigned int type, const char *sdr);
 static unsigned int next_pow2(unsigned int x);
@@ -64,7 +66,9 @@ struct xlivebg_plugin colc_plugin = {
 	start, stop,
 	draw,
 	0,
-	0, 0
+	0, 0,
+	0, 0, 0,
+	draw_sw
 };
 
 static int tex_xsz, tex_ysz;
@@ -78,6 +82,13 @@ static float verts[] = {
 };
 static unsigned int vbo;
 
+/* software rendering: palette as xRGB pixels, and image row/column for each
+ * screen pixel (-1 outside of the image).
+ */
+static uint32_t sw_pal[256];
+static int *sw_xmap, *sw_ymap;
+static int sw_map_size;
+
 static const char *vsdr =
 	"uniform mat4 xform;\n"
 	"uniform vec2 uvscale;\n"
@@ -114,6 +125,8 @@ void resize(int xsz, int ysz)
 	fbwidth = xsz;
 	fbheight = ysz;
 
+	if(xlivebg_software()) return;
+
 	tex_xsz = next_pow2(fbwidth);
 	tex_ysz = next_pow2(fbheight);
 
@@ -139,6 +152,9 @@ static int init(void *cls)
 
 static void cleanup(void *cls)
 {
+	free(sw_xmap);
+	sw_xmap = sw_ymap = 0;
+	sw_map_size = 0;
 }
 
 static int start(long msec, void *cls)
@@ -150,7 +166,7 @@ static int start(long msec, void *cls)
 	argv[1] = (char*)xlivebg_getcfg_str("xlivebg.colcycle.image", argv[1]);
 	if(argv[1] && !*argv[1]) argv[1] = 0;
 
-	if(init_glext() == -1) {
+	if(!xlivebg_software() && init_glext() == -1) {
 		return -1;
 	}
 
@@ -160,6 +176,11 @@ static int start(long msec, void *cls)
 
 	colc_init(argv[1] ? 2 : 1, argv);
 
+	if(xlivebg_software()) {
+		pal_valid = 0;
+		return 0;
+	}
+
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, sizeof verts, verts, GL_STATIC_DRAW);
@@ -266,6 +287,79 @@ static void draw_screen(int scr_idx, long time_msec)
 	assert(glGetError() == GL_NO_ERROR);
 }
 
+static void draw_sw(uint32_t *pixels, int stride, int width, int height, long time_msec, void *cls)
+{
+	int i, j, num_scr;
+	float xform[16], ndc, q;
+	struct xlivebg_screen *scr;
+
+	colc_draw(time_msec);
+
+	if(!pal_valid) {
+		for(i=0; i<256; i++) {
+			sw_pal[i] = ((uint32_t)pal[i * 3] << 16) | ((uint32_t)pal[i * 3 + 1] << 8) | pal[i * 3 + 2];
+		}
+		pal_valid = 1;
+	}
+
+	num_scr = xlivebg_screen_count();
+	for(i=0; i<num_scr; i++) {
+		scr = xlivebg_screen(i);
+		if(scr->x < 0 || scr->y < 0 || scr->x + scr->width > width || scr->y + scr->height > height) {
+			continue;
+		}
+
+		if(scr->width + scr->height > sw_map_size) {
+			int *tmp = realloc(sw_xmap, (scr->width + scr->height) * sizeof *sw_xmap);
+			if(!tmp) {
+				fprintf(stderr, "colcycle: failed to allocate pixel maps\n");
+				return;
+			}
+			sw_xmap = tmp;
+			sw_map_size = scr->width + scr->height;
+		}
+		sw_ymap = sw_xmap + scr->width;
+
+		/* invert the fullscreen quad transformation used by the OpenGL path, to
+		 * find which image pixel ends up at the center of each screen pixel.
+		 */
+		xlivebg_calc_image_proj(i, (float)fbwidth / (float)fbheight, xform);
+
+		for(j=0; j<scr->width; j++) {
+			ndc = (j + 0.5f) / scr->width * 2.0f - 1.0f;
+			q = ((ndc - xform[12]) / xform[0]) * 0.5f + 0.5f;
+			sw_xmap[j] = q >= 0.0f && q < 1.0f ? (int)(q * fbwidth) : -1;
+		}
+		for(j=0; j<scr->height; j++) {
+			ndc = 1.0f - (j + 0.5f) / scr->height * 2.0f;
+			q = ((ndc - xform[13]) / xform[5]) * -0.5f + 0.5f;
+			sw_ymap[j] = q >= 0.0f && q < 1.0f ? (int)(q * fbheight) : -1;
+		}
+
+		xlivebg_sw_tiles(pixels + scr->y * stride + scr->x, stride, scr->width,
+				scr->height, draw_sw_tile, 0);
+	}
+}
+
+static void draw_sw_tile(uint32_t *pixels, int stride, int x, int y, int w, int h, void *cls)
+{
+	int i, j, sx;
+	unsigned char *src;
+
+	for(i=0; i<h; i++) {
+		if(sw_ymap[y + i] < 0) {
+			memset(pixels, 0, w * sizeof *pixels);
+		} else {
+			src = fbpixels + sw_ymap[y + i] * fbwidth;
+			for(j=0; j<w; j++) {
+				sx = sw_xmap[x + j];
+				pixels[j] = sx >= 0 ? sw_pal[src[sx]] : 0;
+			}
+		}
+		pixels += stride;
+	}
+}
+
 static unsigned int create_program(const char *vsdr, const char *psdr)
 {
 	unsigned int vs, ps, prog;
@@ -22,11 +22,15 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 static int init(void *cls);
 static int start(long tmsec, void *cls);
-static void draw(long tmsec, void *cls);
+static void draw_screen(int scr, long tmsec, void *cls);
 static void prop(const char *prop, void *cls);
+static void quality(int level, void *cls);
+
+#define QUALITY_LEVELS	3
 
 #define PROPLIST	\
 	"proplist {\n" \
+	"    quality_levels = 3\n" \
 	"    prop {\n" \
 	"        id = \"amplitude\"\n" \
 	"        desc = \"amplitude of the distortion\"\n" \
@@ -48,9 +52,12 @@ static struct xlivebg_plugin plugin = {
 	XLIVEBG_25FPS,
 	init, 0,
 	start, 0,
-	draw,
+	0,
 	prop,
-	0, 0
+	0, 0,
+	0,
+	draw_screen,
+	quality
 };
 
 static float ampl, freq;
@@ -71,6 +78,7 @@ static int start(long tmsec, void *cls)
 {
 	prop("amplitude", 0);
 	prop("frequency", 0);
+	quality(xlivebg_quality(), 0);
 	return 0;
 }
 
@@ -79,6 +87,8 @@ static void prop(const char *prop, void *cls)
 	switch(prop[0]) {
 	case 'a':	/* amplitude */
 		ampl = xlivebg_getcfg_num("xlivebg.distort.amplitude", 0.025);
+		/* without any distortion, it's just the background image */
+		xlivebg_set_static(ampl == 0.0f);
 		break;
 	case 'f':	/* frequency */
 		freq = xlivebg_getcfg_num("xlivebg.distort.frequency", 8.0);
@@ -89,6 +99,15 @@ static void prop(const char *prop, void *cls)
 #define USUB	45
 #define VSUB	20
 
+/* mesh subdivision, scaled down by the adaptive quality level */
+static int usub = USUB, vsub = VSUB;
+
+static void quality(int level, void *cls)
+{
+	usub = USUB * (level + 1) / QUALITY_LEVELS;
+	vsub = VSUB * (level + 1) / QUALITY_LEVELS;
+}
+
 static float wave(float x, float frq, float amp, float t)
 {
 	t *= 0.5;
@@ -134,8 +153,8 @@ static void emit_vertex(float x, float y, float u, float v, float au, float av,
 static void distquad(float t, struct xlivebg_image *amask)
 {
 	int i, j;
-	float du = 1.0f / (float)USUB;
-	float dv = 1.0f / (float)VSUB;
+	float du = 1.0f / (float)usub;
+	float dv = 1.0f / (float)vsub;
 	float dx = du * 2.0f;
 	float dy = dv * 2.0f;
 
@@ -143,7 +162,7 @@ static void distquad(float t, struct xlivebg_image *amask)
 	glLoadIdentity();
 
 	glBegin(GL_QUADS);
-	for(i=0; i<VSUB; i++) {
+	for(i=0; i<vsub; i++) {
 		float av0, av1;
 		float v0 = (float)i * dv;
 		float v1 = v0 + dv;
@@ -152,7 +171,7 @@ static void distquad(float t, struct xlivebg_image *amask)
 		av0 = wave(v0, freq * 2.0f, dmask(v0) * ampl * 0.75, t);
 		av1 = wave(v1, freq * 2.0f, dmask(v1) * ampl * 0.75, t);
 
-		for(j=0; j<USUB; j++) {
+		for(j=0; j<usub; j++) {
 			float au0, au1;
 			float u0 = (float)j * du;
 			float u1 = u0 + du;
@@ -170,30 +189,29 @@ static void distquad(float t, struct xlivebg_image *amask)
 	glEnd();
 }
 
-static void draw(long tmsec, void *cls)
+/* the viewport and scissor rectangle are already set to the screen. The
+ * viewport is set again after clearing, in case the background drawing
+ * changed it.
+ */
+static void draw_screen(int scr, long tmsec, void *cls)
 {
-	int i, num_scr;
 	struct xlivebg_image *img;
 	float xform[16];
-	float t = (float)tmsec / 1000.0f;
+	float t = (float)((double)xlivebg_time_usec() / 1000000.0);
 
 	xlivebg_clear(GL_COLOR_BUFFER_BIT);
+	xlivebg_gl_viewport(scr);
 
-	num_scr = xlivebg_screen_count();
-	for(i=0; i<num_scr; i++) {
-		xlivebg_gl_viewport(i);
-
-		if((img = xlivebg_bg_image(i)) && img->tex) {
-			struct xlivebg_image *amask = xlivebg_anim_mask(i);
+	if((img = xlivebg_bg_image(scr)) && img->tex) {
+		struct xlivebg_image *amask = xlivebg_anim_mask(scr);
 
-			xlivebg_calc_image_proj(i, (float)img->width / img->height, xform);
-			glMatrixMode(GL_PROJECTION);
-			glLoadMatrixf(xform);
+		xlivebg_calc_image_proj(scr, (float)img->width / img->height, xform);
+		glMatrixMode(GL_PROJECTION);
+		glLoadMatrixf(xform);
 
-			glBindTexture(GL_TEXTURE_2D, img->tex);
-			glEnable(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, img->tex);
+		glEnable(GL_TEXTURE_2D);
 
-			distquad(t, amask);
-		}
+		distquad(t, amask);
 	}
 }
@@ -29,7 +29,9 @@ static struct xlivebg_plugin plugin = {
 	start, stop,
 	draw,
 	prop,
-	0, 0
+	0, 0,
+	0, 0,
+	quality
 };
 
 
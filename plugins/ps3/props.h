@@ -19,6 +19,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #define PROPLIST	\
 	"proplist {\n" \
+	"    quality_levels = 4\n" \
 	"    prop {\n" \
 	"        id = \"light_angle\"\n" \
 	"        desc = \"Angle the directional light is facing on the YZ plane\"\n" \
@@ -56,6 +57,11 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 	"    }\n" \
 	"}\n"
 
+/* the wave grid size at the highest quality level, lower levels scale it down */
+#define GRID_WIDTH 1250
+#define GRID_LENGTH 500
+#define QUALITY_LEVELS 4
+
 #define CHAOS_DEFAULT 1.36f
 #define DETAIL_DEFAULT 2.2f
 #define SPEED_DEFAULT 0.9f
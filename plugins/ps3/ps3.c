@@ -39,7 +39,6 @@ unsigned int create_sdrprog(const char *vsrc, const char *psrc);
 
 static vertex *varr = NULL;
 static unsigned int *iarr = NULL;
-static long prev_upd;
 static unsigned int w, l;
 static unsigned int prog;
 static unsigned int vao, vbo, ibo;
@@ -59,24 +58,31 @@ extern const char wave_v, wave_f;
 
 
 int init(void *cls) {
-	unsigned int x, z;
-	unsigned int *ibase;
-
 	xlivebg_defcfg_num("xlivebg.ps3.light_angle", LIGHT_ANGLE_DEFAULT);
 	xlivebg_defcfg_num("xlivebg.ps3.chaos", CHAOS_DEFAULT);
 	xlivebg_defcfg_num("xlivebg.ps3.detail", DETAIL_DEFAULT);
 	xlivebg_defcfg_num("xlivebg.ps3.speed", SPEED_DEFAULT);
 	xlivebg_defcfg_num("xlivebg.ps3.scale", SCALE_DEFAULT);
 	xlivebg_defcfg_vec("xlivebg.ps3.wave_color", wave_color_default);
-	w = 1250;
-	l = 500;
+	w = GRID_WIDTH;
+	l = GRID_LENGTH;
 	prog = vao = vbo = ibo = 0;
+	return 0;
+}
+
+/* the grid is only needed until it's uploaded to the vertex/index buffers
+ * in upload_grid, so it's built there and freed right after.
+ */
+static int build_grid(void) {
+	unsigned int x, z;
+	unsigned int *ibase;
 
 	if(!(varr = malloc(sizeof(vertex) * w * l))) {
 		return -1;
 	}
 	if(!(iarr = malloc(sizeof(unsigned int) * w * l * 4))) {
 		free(varr);
+		varr = NULL;
 		return -1;
 	}
 	ibase = iarr;
@@ -99,6 +105,25 @@ int init(void *cls) {
 	return 0;
 }
 
+static void free_grid(void) {
+	free(varr);
+	free(iarr);
+	varr = NULL;
+	iarr = NULL;
+}
+
+/* expects the vertex array object to be bound */
+static int upload_grid(void) {
+	if (build_grid() == -1) return -1;
+
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertex) * w * l, varr, GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * 4 * (w - 1) * (l - 1), iarr, GL_STATIC_DRAW);
+
+	free_grid();
+	return 0;
+}
+
 void deinit(void* cls) {
 }
 
@@ -107,8 +132,7 @@ void stop(void* cls) {
 	if (ibo) glDeleteBuffers(1, &ibo);
 	if (vao) glDeleteVertexArrays(1, &vao);
 	if (prog) glDeleteProgram(prog);
-	if (varr) free(varr);
-	if (iarr) free(iarr);
+	prog = vao = vbo = ibo = 0;
 }
 
 int start(long tmsec, void *cls) {
@@ -119,8 +143,6 @@ int start(long tmsec, void *cls) {
 	prop("scale", 0);
 	prop("wave_color", 0);
 
-	prev_upd = tmsec;
-
 	printf("creating shaders\n");
 	prog = create_sdrprog(&wave_v, &wave_f);
 
@@ -144,11 +166,13 @@ int start(long tmsec, void *cls) {
 
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertex) * w * l, varr, GL_STATIC_DRAW);
-
 	glGenBuffers(1, &ibo);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * 4 * (w - 1) * (l - 1), iarr, GL_STATIC_DRAW);
+
+	quality(xlivebg_quality(), 0);
+	if (!vbo) return -1;
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
 	/* position */
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)0);
@@ -184,26 +208,40 @@ void prop(const char *name, void *cls) {
 	}
 }
 
+/* adaptive quality changes the density of the wave grid */
+void quality(int level, void *cls) {
+	w = GRID_WIDTH * (level + 1) / QUALITY_LEVELS;
+	l = GRID_LENGTH * (level + 1) / QUALITY_LEVELS;
+
+	if (!vao) return;
+
+	glBindVertexArray(vao);
+	if (upload_grid() == -1) {
+		fprintf(stderr, "ps3: failed to allocate the wave grid\n");
+		stop(0);
+	}
+	glBindVertexArray(0);
+}
+
 void draw(long tmsec, void *cls) {
 	int i, num_scr;
-	prev_upd = tmsec;
 
 	xlivebg_clear(GL_COLOR_BUFFER_BIT);
 
 	num_scr = xlivebg_screen_count();
 	for (i = 0;i < num_scr;i++) {
 		xlivebg_gl_viewport(i);
-		draw_wave(tmsec);
+		draw_wave();
 	}
 }
 
-void draw_wave(long tmsec) {
+void draw_wave(void) {
 	float tsec;
 
 	if (!prog || !vao || !vbo || !ibo) return;
 
 	/* todo: move this to vertex shader / calculate normals */
-	tsec = (float)tmsec / 1000.0f;
+	tsec = (float)((double)xlivebg_time_usec() / 1000000.0);
 
 	glPushAttrib(GL_ENABLE_BIT);
 	glDisable(GL_DEPTH_TEST);
@@ -30,6 +30,7 @@ void deinit(void *cls);
 int start(long tmsec, void *cls);
 void stop(void *cls);
 void prop(const char *name, void *cls);
+void quality(int level, void *cls);
 void draw(long tmsec, void *cls);
-void draw_wave(long tmsec);
+void draw_wave(void);
 void perspective(float *m, float vfov, float aspect, float znear, float zfar);
@@ -30,12 +30,14 @@ static int start(long time_msec, void *cls);
 static void resize(int x, int y);
 static void stop(void *cls);
 static void prop(const char *prop, void *cls);
+static void quality(int level, void *cls);
 static void draw(long time_msec, void *cls);
 static unsigned int create_shader(const char *src, unsigned int type);
 static unsigned int create_sdrprog(const char *vsrc, const char *psrc);
 
 #define PROPLIST	\
 	"proplist {\n" \
+	"    quality_levels = 3\n" \
 	"    prop {\n" \
 	"        id = \"raindrops\"\n" \
 	"        desc = \"number of raindrops per second\"\n" \
@@ -53,7 +55,9 @@ static struct xlivebg_plugin plugin = {
 	start, stop,
 	draw,
 	prop,
-	0, 0
+	0, 0,
+	0, 0,
+	quality
 };
 
 static int scr_width, scr_height;
@@ -67,7 +71,6 @@ static int blur_delta_loc;
 
 static float mpos[2], prev_mpos[2];
 static float rain_rate, pending_drops;
-static long prev_upd;
 
 extern const char ripple_vsdr, ripple_psdr;
 extern const char ripple_waves_vsdr, ripple_waves_psdr;
@@ -77,7 +80,11 @@ extern const char ripple_waves_vsdr, ripple_waves_psdr;
 #define TEX_DEST	((frame ^ 1) & 1)
 #define TEX_AUX		2
 
-#define TEX_SIZE_DIV	2
+/* the simulation runs at a fraction of the screen resolution, which depends
+ * on the adaptive quality level.
+ */
+static const int tex_size_div[] = {8, 4, 2};
+static int tex_div = 2, cur_tex_div;
 #define PLONK_SIZE		0.01
 
 
@@ -171,6 +178,7 @@ static int start(long time_msec, void *cls)
 	}
 
 	/* and allocate storage for the textures to cover the whole root window */
+	tex_div = tex_size_div[xlivebg_quality()];
 	resize(scr->root_width, scr->root_height);
 
 	/* create the FBO */
@@ -182,14 +190,11 @@ static int start(long time_msec, void *cls)
 	}
 
 	/* initialize the first texture to 0.5 (which maps to 0 in the wave calculation) */
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	glAlphaFunc(GL_GREATER, 0.5f);	/* using alpha-testing for non-stretch fits */
+	glBindFramebuffer(GL_FRAMEBUFFER, xlivebg_framebuffer());
 
 	prop("raindrops", 0);
 
 	pending_drops = 0;
-	prev_upd = time_msec;
 
 	return 0;
 }
@@ -217,16 +222,23 @@ static void prop(const char *prop, void *cls)
 	}
 }
 
+/* the new resolution takes effect in the next resize call, from draw */
+static void quality(int level, void *cls)
+{
+	tex_div = tex_size_div[level];
+}
+
 /* TODO: pow2 */
 static void resize(int x, int y)
 {
 	int i;
 	unsigned char *pixels;
 
-	if(x == scr_width && y == scr_height) return;
+	if(x == scr_width && y == scr_height && tex_div == cur_tex_div) return;
 
 	scr_width = x;
 	scr_height = y;
+	cur_tex_div = tex_div;
 	scr_aspect = (float)x / (float)y;
 
 	pixels = alloca(x * y);
@@ -234,12 +246,12 @@ static void resize(int x, int y)
 
 	for(i=0; i<3; i++) {
 		glBindTexture(GL_TEXTURE_2D, ripple_tex[i]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, x / TEX_SIZE_DIV, y / TEX_SIZE_DIV,
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, x / tex_div, y / tex_div,
 				0, GL_LUMINANCE, GL_UNSIGNED_BYTE, pixels);
 	}
 
 	glUseProgram(sdr_waves);
-	glUniform2f(blur_delta_loc, (float)TEX_SIZE_DIV / x, (float)TEX_SIZE_DIV / y);
+	glUniform2f(blur_delta_loc, (float)tex_div / x, (float)tex_div / y);
 }
 
 static void plonk(float u, float v)
@@ -257,17 +269,15 @@ static void plonk(float u, float v)
 	glEnd();
 }
 
-static void update_ripple(long time_msec)
+static void update_ripple(void)
 {
 	int mouse_moved;
-	float dt = (time_msec - prev_upd) / 1000.0f;
-	prev_upd = time_msec;
 
-	pending_drops += rain_rate * dt;
+	pending_drops += rain_rate * xlivebg_frame_delta();
 	mouse_moved = mpos[0] != prev_mpos[0] || mpos[1] != prev_mpos[1];
 
 	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-	glViewport(0, 0, scr_width / TEX_SIZE_DIV, scr_height / TEX_SIZE_DIV);
+	glViewport(0, 0, scr_width / tex_div, scr_height / tex_div);
 
 	/* draw any new drops in the previous buffer first */
 	if(mouse_moved || pending_drops >= 1.0f) {
@@ -303,8 +313,8 @@ static void update_ripple(long time_msec)
 
 	/* copy the contents of the destination texture to the auxiliary */
 	glBindTexture(GL_TEXTURE_2D, ripple_tex[2]);
-	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, scr_width / TEX_SIZE_DIV,
-			scr_height / TEX_SIZE_DIV);
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, scr_width / tex_div,
+			scr_height / tex_div);
 
 	/* do the ripple blur effect from src -> dest */
 	glActiveTexture(GL_TEXTURE1);
@@ -324,7 +334,7 @@ static void update_ripple(long time_msec)
 	glVertex2f(-1, 1);
 	glEnd();
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, xlivebg_framebuffer());
 }
 
 static void draw(long time_msec, void *cls)
@@ -346,9 +356,10 @@ static void draw(long time_msec, void *cls)
 	mpos[0] = (float)mx / scr->root_width * 2.0f - 1.0f;
 	mpos[1] = (float)my / scr->root_height * 2.0f - 1.0f;
 
-	update_ripple(time_msec);
+	update_ripple();
 
 	glEnable(GL_ALPHA_TEST);
+	glAlphaFunc(GL_GREATER, 0.5f);	/* using alpha-testing for non-stretch fits */
 
 	glUseProgram(sdr_vis);
 	/* use the destination of the blur from update_ripple as texture 1*/
@@ -50,10 +50,12 @@ struct vertex {
 };
 
 static int init(void *cls);
+static void cleanup(void *cls);
 static int start(long tmsec, void *cls);
 static void prop(const char *name, void *cls);
+static void quality(int level, void *cls);
 static void draw(long tmsec, void *cls);
-static void draw_stars(long tmsec);
+static void draw_stars(void);
 static void perspective(float *m, float vfov, float aspect, float znear, float zfar);
 
 static struct star *star;
@@ -63,8 +65,12 @@ static float targ[2], cam[2];
 static struct vertex *varr;
 static unsigned short *iarr;
 
+/* adaptive quality scales down the number of stars */
+#define QUALITY_LEVELS	4
+
 #define PROPLIST	\
 	"proplist {\n" \
+	"    quality_levels = 4\n" \
 	"    prop {\n" \
 	"        id = \"count\"\n" \
 	"        desc = \"number of stars\"\n" \
@@ -108,15 +114,17 @@ static struct xlivebg_plugin plugin = {
 	"Starfield effect",
 	PROPLIST,
 	XLIVEBG_20FPS,
-	init, 0,
+	init, cleanup,
 	start, 0,
 	draw,
 	prop,
-	0, 0
+	0, 0,
+	0, 0,
+	quality
 };
 
-static long prev_upd;
 static int star_count;
+static int qlevel = QUALITY_LEVELS - 1;
 static float star_speed, star_size;
 static float follow;
 static float follow_speed;
@@ -145,8 +153,22 @@ static int init(void *cls)
 	return 0;
 }
 
+static void cleanup(void *cls)
+{
+	xlivebg_destroy_image(&pimg);
+	xlivebg_destroy_image(&bolt);
+
+	free(star);
+	free(varr);
+	free(iarr);
+	star = 0;
+	varr = 0;
+	iarr = 0;
+}
+
 static int start(long tmsec, void *cls)
 {
+	qlevel = xlivebg_quality();
 	prop("count", 0);
 	prop("speed", 0);
 	prop("size", 0);
@@ -154,8 +176,6 @@ static int start(long tmsec, void *cls)
 	prop("follow", 0);
 	prop("follow_speed", 0);
 
-	prev_upd = tmsec;
-
 	return 0;
 }
 
@@ -170,6 +190,7 @@ static void prop(const char *name, void *cls)
 		if(star_count > MAX_STAR_COUNT) {
 			star_count = MAX_STAR_COUNT;
 		}
+		star_count = star_count * (qlevel + 1) / QUALITY_LEVELS;
 
 		free(star);
 		if((star = malloc(star_count * sizeof *star))) {
@@ -182,6 +203,8 @@ static void prop(const char *name, void *cls)
 				star[i].lenxy = sqrt(star[i].pos.x * star[i].pos.x + star[i].pos.y * star[i].pos.y);
 			}
 		}
+		free(varr);
+		free(iarr);
 		varr = malloc(star_count * 4 * sizeof *varr);
 		if((iarr = malloc(star_count * 6 * sizeof *iarr))) {
 			unsigned short *iptr = iarr;
@@ -215,19 +238,21 @@ static void prop(const char *name, void *cls)
 	}
 }
 
+static void quality(int level, void *cls)
+{
+	qlevel = level;
+	prop("count", 0);
+}
+
 static void draw(long tmsec, void *cls)
 {
 	int i, num_scr, mx, my;
 	struct xlivebg_screen *scr;
 	float proj[16];
 	float aspect;
-	long dtms;
-
-	dtms = tmsec - prev_upd;
-	prev_upd = tmsec;
 
 	if(follow > 0.0f) {
-		float t = follow_speed * (dtms / 1000.0f);
+		float t = follow_speed * xlivebg_frame_delta();
 
 		scr = xlivebg_screen(0);
 		xlivebg_mouse_pos(&mx, &my);
@@ -257,7 +282,7 @@ static void draw(long tmsec, void *cls)
 			gluLookAt(0, 0, 0, cam[0], cam[1], -1, 0, 1, 0);
 		}
 
-		draw_stars(tmsec);
+		draw_stars();
 	}
 }
 
@@ -282,12 +307,12 @@ static unsigned char cur_col[4];
 		vptr++; \
 	} while(0)
 
-static void draw_stars(long tmsec)
+static void draw_stars(void)
 {
 	int i;
 	float z, t, x, y, x0, y0, x1, y1, theta, sz, ssize;
 	struct vec3 pos;
-	double tsec = (double)tmsec / 1000.0;
+	double tsec = (double)xlivebg_time_usec() / 1000000.0;
 	struct vertex *vptr;
 
 	glPushAttrib(GL_ENABLE_BIT);
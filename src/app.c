@@ -23,39 +23,52 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "imageman.h"
 #include "plugin.h"
 #include "cfg.h"
+#include "damage.h"
+#include "sched.h"
+#include "swrender.h"
+#include "host.h"
+#include "layer.h"
+#include "bgcache.h"
+#include "rscale.h"
+#include "loopcache.h"
 
 unsigned int bgtex;
 unsigned long msec;
+int64_t frame_time_usec;
+long frame_delta_usec;
+unsigned long frame_count;
 long upd_interval_usec;
 
 int scr_width, scr_height;
 
+int sw_render;
+
 struct xlivebg_screen screen[MAX_SCR];
 int num_screens;
 
+int vis_screen[MAX_SCR];
+int num_vis_screens;
+
+/* per-screen update schedule, for plugins which draw each screen separately */
+static long scr_interval[MAX_SCR];
+static int64_t scr_next[MAX_SCR];
+
+static void draw_layers(void);
+static void draw_screens(struct xlivebg_plugin *plugin, int retained);
+static void draw_sw(struct xlivebg_plugin *plugin);
+static void draw_cached(struct xlivebg_plugin *plugin);
+
 
 int app_init(int argc, char **argv)
 {
 	int i, num_plugins;
-	struct xlivebg_plugin *first_plugin = 0;
 
 	init_imgman();
 	init_plugins();
 
-	num_plugins = get_plugin_count();
-	for(i=0; i<num_plugins; i++) {
-		struct xlivebg_plugin *plugin = get_plugin(i);
-
-		if(plugin->init && plugin->init(plugin->data) == -1) {
-			fprintf(stderr, "xlivebg: plugin %s failed to initialize\n", plugin->name);
-			remove_plugin(i--);
-			num_plugins--;
-			continue;
-		}
-
-		if(!first_plugin) first_plugin = plugin;
-	}
-
+	/* plugins are only initialized when they're first activated. If one
+	 * fails to initialize, drop it and try the next one.
+	 */
 	if(cfg.act_plugin) {
 		struct xlivebg_plugin *p = find_plugin(cfg.act_plugin);
 		if(!p) {
@@ -65,8 +78,12 @@ int app_init(int argc, char **argv)
 		}
 	}
 
-	if(!get_active_plugin() && first_plugin) {
-		activate_plugin(first_plugin);
+	num_plugins = get_plugin_count();
+	for(i=0; i<num_plugins && !get_active_plugin(); i++) {
+		if(activate_plugin(get_plugin(i)) == -1) {
+			remove_plugin(i--);
+			num_plugins--;
+		}
 	}
 
 	return 0;
@@ -76,50 +93,282 @@ void app_cleanup(void)
 {
 	int i, num_plugins;
 
+	cleanup_plugins();
+
 	num_plugins = get_plugin_count();
 	for(i=0; i<num_plugins; i++) {
-		struct xlivebg_plugin *plugin = get_plugin(i);
-		void *so = plugin->so;
+		if(get_plugin(i)->so) {
+			dlclose(get_plugin(i)->so);
+		}
+	}
+}
+
+/* hidden_mask has a bit set for every screen which doesn't need to be drawn */
+void update_visible_screens(unsigned int hidden_mask)
+{
+	static unsigned int prev_mask;
+	int i, prev_vis = num_vis_screens;
 
-		if(plugin->cleanup) {
-			plugin->cleanup(plugin->data);
+	num_vis_screens = 0;
+	for(i=0; i<num_screens; i++) {
+		if(!(hidden_mask & (1u << i))) {
+			vis_screen[num_vis_screens++] = i;
 		}
+	}
 
-		dlclose(so);
+	if(hidden_mask != prev_mask) {
+		/* outputs which were covered until now have to be drawn in full */
+		damage_invalidate();
+		layer_invalidate();
+		loopcache_invalidate();
+		prev_mask = hidden_mask;
 	}
+
+	if(num_vis_screens != prev_vis) {
+		printf("xlivebg: %d of %d outputs visible\n", num_vis_screens, num_screens);
+	}
+}
+
+void app_suspend(int susp)
+{
+	int i, num_layers = layer_count();
+	struct xlivebg_plugin *plugin = get_active_plugin();
+
+	/* isolated plugins are never touched in this process */
+	if(plugin && plugin->suspend && !host_active()) {
+		plugin->suspend(susp, plugin->data);
+	}
+	for(i=1; i<num_layers; i++) {
+		plugin = layer_plugin(i);
+		if(plugin->suspend) {
+			plugin->suspend(susp, plugin->data);
+		}
+	}
+}
+
+void app_frame_time(int64_t usec)
+{
+	frame_delta_usec = frame_count ? usec - frame_time_usec : 0;
+	frame_time_usec = usec;
+	msec = usec / 1000;
+	frame_count++;
+}
+
+/* computes the update interval of each visible screen, from the output
+ * sections of the config file, falling back to the requested interval. The
+ * frame interval is the shortest of them, and of the update intervals of any
+ * layers on top. Only plugins with a draw_screen function can be updated
+ * per-screen.
+ */
+long app_frame_interval(long interval)
+{
+	int i, idx, fps;
+	long min = -1;
+	struct xlivebg_plugin *plugin = get_active_plugin();
+
+	if(!plugin || !plugin->draw_screen) {
+		return layer_frame_interval(interval);
+	}
+
+	for(i=0; i<num_vis_screens; i++) {
+		idx = vis_screen[i];
+		fps = cfg_output_fps(idx, screen[idx].name);
+		scr_interval[idx] = fps > 0 ? 1000000 / fps : interval;
+
+		if(scr_interval[idx] > 0 && (min <= 0 || scr_interval[idx] < min)) {
+			min = scr_interval[idx];
+		}
+	}
+	return layer_frame_interval(min > 0 ? min : interval);
 }
 
 void app_draw(void)
 {
 	struct xlivebg_plugin *plugin = get_active_plugin();
 
+	int scaled;
+
+	if(sw_render) {
+		draw_sw(plugin);
+		return;
+	}
+
+	scaled = rscale_begin();
+
 	if(plugin) {
-		plugin->draw(msec, plugin->data);
+		if(layer_count()) {
+			draw_layers();
+		} else if(loopcache_active()) {
+			draw_cached(plugin);
+		} else {
+			app_draw_plugin(plugin, scaled ? rscale_valid() : damage_partial());
+		}
 	} else {
 		glClearColor(0.2, 0.1, 0.1, 1);
 		glClear(GL_COLOR_BUFFER_BIT);
 	}
 
-#ifdef PRINT_FPS
-	{
-		static long frame, prev_fps_upd;
-		frame++;
-		if(msec - prev_fps_upd >= 1000) {
-			long fps = 10000 * frame / (msec - prev_fps_upd);
-			printf("\rframerate: %4ld.%02ld fps", fps / 10, fps % 10);
+	if(scaled) {
+		rscale_end();
+	}
+}
+
+/* draws the active plugin, in its host process if it's isolated. retained is
+ * passed on to draw_screens.
+ */
+void app_draw_plugin(struct xlivebg_plugin *plugin, int retained)
+{
+	if(host_active()) {
+		host_draw_gl(rscale_width(), rscale_height(), 0);
+	} else if(plugin->draw_screen) {
+		draw_screens(plugin, retained);
+	} else {
+		plugin->draw(msec, plugin->data);
+	}
+}
 
-			frame = 0;
-			prev_fps_upd = msec;
-			fflush(stdout);
+/* draws every layer which is due for an update into its framebuffer, and
+ * blends them onto the window. Only the bottom layer (the active plugin) is
+ * updated per-screen, the rest draw all screens at once.
+ */
+static void draw_layers(void)
+{
+	int i, j, num_layers = layer_count();
+	int64_t now = sched_time_usec();
+	struct xlivebg_plugin *plugin;
+	struct xlivebg_screen *scr;
+
+	for(i=0; i<num_layers; i++) {
+		if(!layer_begin(i, now)) continue;
+
+		plugin = layer_plugin(i);
+		if(i == 0) {
+			app_draw_plugin(plugin, layer_valid(0));
+		} else if(!plugin->draw_screen) {
+			plugin->draw(msec, plugin->data);
+		} else {
+			for(j=0; j<num_vis_screens; j++) {
+				scr = screen + vis_screen[j];
+				glViewport(scr->vport[0], scr->vport[1], scr->vport[2], scr->vport[3]);
+				glScissor(scr->vport[0], scr->vport[1], scr->vport[2], scr->vport[3]);
+				glEnable(GL_SCISSOR_TEST);
+
+				plugin->draw_screen(j, msec, plugin->data);
+			}
+			glDisable(GL_SCISSOR_TEST);
+		}
+		layer_end();
+	}
+	layer_composite();
+}
+
+/* calls draw_screen for every visible screen which is due for an update.
+ * Screens can only be skipped if the rest of the frame is retained, either in
+ * the back buffer (if the damage module can keep it intact), in the
+ * framebuffer of the bottom layer, or in the render target. Otherwise they're
+ * all drawn every frame.
+ */
+static void draw_screens(struct xlivebg_plugin *plugin, int retained)
+{
+	int i, idx, partial;
+	int64_t now = sched_time_usec();
+	long slack = sched_interval() / 2;
+	struct xlivebg_screen *scr;
+
+	/* damage is only reported when drawing directly on the window */
+	if((partial = retained && !layer_count() && !rscale_active())) {
+		/* nothing changed, unless some screen is due */
+		damage_add(0, 0, 0, 0);
+	}
+
+	for(i=0; i<num_vis_screens; i++) {
+		idx = vis_screen[i];
+		scr = screen + idx;
+
+		if(scr_interval[idx] > 0) {
+			if(retained && scr_next[idx] - slack > now) {
+				continue;
+			}
+			scr_next[idx] += scr_interval[idx];
+			if(scr_next[idx] <= now) {
+				scr_next[idx] = now + scr_interval[idx];
+			}
+		}
+
+		if(partial) {
+			damage_add(scr->x, scr->y, scr->width, scr->height);
+		}
+		glViewport(scr->vport[0], scr->vport[1], scr->vport[2], scr->vport[3]);
+		glScissor(scr->vport[0], scr->vport[1], scr->vport[2], scr->vport[3]);
+		glEnable(GL_SCISSOR_TEST);
+
+		plugin->draw_screen(i, msec, plugin->data);
+	}
+	glDisable(GL_SCISSOR_TEST);
+}
+
+/* periodic animations: frames which aren't in the loop cache yet are drawn by
+ * the plugin, at the time the cached frame stands for, and stored. The rest
+ * are played back from the cache.
+ */
+static void draw_cached(struct xlivebg_plugin *plugin)
+{
+	unsigned long t, frame_msec = msec;
+	int64_t frame_time = frame_time_usec;
+	long frame_delta = frame_delta_usec;
+
+	if(!loopcache_need(msec, &t)) {
+		loopcache_draw(msec);
+		return;
+	}
+
+	/* the plugin sees the time of the cached frame, through every time call */
+	msec = t;
+	frame_time_usec = (int64_t)t * 1000;
+	frame_delta_usec = loopcache_frame_interval();
+	if(host_active()) {
+		/* the frame is stored right away, it can't be the previous one */
+		host_draw_gl(rscale_width(), rscale_height(), 1);
+	} else {
+		app_draw_plugin(plugin, 0);
+	}
+	msec = frame_msec;
+	frame_time_usec = frame_time;
+	frame_delta_usec = frame_delta;
+
+	loopcache_store();
+}
+
+/* software rendering: the plugin draws the whole framebuffer in one go */
+static void draw_sw(struct xlivebg_plugin *plugin)
+{
+	int i, stride;
+	uint32_t *pixels;
+
+	if(!(pixels = swr_framebuffer(&stride))) {
+		return;
+	}
+
+	if(host_active()) {
+		host_draw(pixels, stride, scr_width, scr_height);
+	} else if(plugin) {
+		plugin->draw_sw(pixels, stride, scr_width, scr_height, msec, plugin->data);
+	} else {
+		for(i=0; i<stride * scr_height; i++) {
+			pixels[i] = 0x331a1a;
 		}
 	}
-#endif
 }
 
 void app_reshape(int x, int y)
 {
 	scr_width = x;
 	scr_height = y;
+	if(sw_render) {
+		swr_resize(x, y);
+	}
+	damage_invalidate();
+	rscale_update();
 }
 
 void app_keyboard(int key, int pressed)
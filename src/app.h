@@ -22,18 +22,46 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 extern unsigned int bgtex;
 extern unsigned long msec;
+extern int64_t frame_time_usec;
+extern long frame_delta_usec;
+extern unsigned long frame_count;
 extern long upd_interval_usec;
 
 extern int scr_width, scr_height;
 
+/* non-zero when drawing with the software renderer instead of OpenGL */
+extern int sw_render;
+
 #define MAX_SCR	32
 extern struct xlivebg_screen screen[MAX_SCR];
 extern int num_screens;
 
+/* indices into screen[] of the screens which are not covered, and need drawing */
+extern int vis_screen[MAX_SCR];
+extern int num_vis_screens;
+
 int app_init(int argc, char **argv);
 void app_cleanup(void);
 
+void update_visible_screens(unsigned int hidden_mask);
+
+void app_suspend(int susp);
+
+/* sets the animation time for the next frame, and updates msec and the
+ * frame delta/count returned by the plugin API
+ */
+void app_frame_time(int64_t usec);
+/* returns the frame interval to use, given the requested one, taking into
+ * account any per-output framerates for plugins drawing each screen separately.
+ */
+long app_frame_interval(long interval);
 void app_draw(void);
+/* draws the active plugin (or the bottom layer), either with draw, or with
+ * draw_screen for each visible screen, or in its host process if it's
+ * isolated. With retained non-zero, draw_screen is only called for the
+ * screens due for an update.
+ */
+void app_draw_plugin(struct xlivebg_plugin *plugin, int retained);
 void app_reshape(int x, int y);
 
 void app_keyboard(int key, int pressed);
@@ -44,6 +72,14 @@ unsigned int app_getmouse(int *x, int *y);
 
 int xlivebg_init_gl(void);
 void xlivebg_destroy_gl(void);
+/* releases the OpenGL context (bind 0) while forking a plugin host process,
+ * and makes it current again (bind 1).
+ */
+void xlivebg_bind_gl(int bind);
+/* in a plugin host process, opens a connection to the X server and an OpenGL
+ * context of its own, drawing to a width x height pbuffer.
+ */
+int xlivebg_init_host_gl(int width, int height);
 
 
 #endif	/* APP_H_ */
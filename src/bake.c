@@ -0,0 +1,205 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/Xatom.h>
+#include "opengl.h"
+#include "bake.h"
+#include "app.h"
+#include "sched.h"
+#include "timesrc.h"
+#include "swrender.h"
+
+static uint32_t *read_frame(int *stride);
+static Pixmap create_pixmap(Display *dpy, Window root, uint32_t *pixels, int stride);
+static void set_root_pixmap(Display *dpy, Window root, Pixmap pix);
+static int mask_shift(unsigned long mask);
+static int native_byte_order(void);
+
+static uint32_t *readback;
+
+
+int bake_run(Display *dpy, Window root)
+{
+	int64_t now;
+	int stride;
+	uint32_t *pixels;
+	Pixmap pix;
+
+	now = sched_time_usec();
+	timesrc_reset(now);
+	app_frame_time(timesrc_frame(now));
+	app_draw();
+
+	if(!(pixels = read_frame(&stride))) {
+		return -1;
+	}
+	pix = create_pixmap(dpy, root, pixels, stride);
+	free(readback);
+	readback = 0;
+	if(!pix) {
+		return -1;
+	}
+
+	set_root_pixmap(dpy, root, pix);
+	printf("xlivebg: baked a %dx%d frame into root pixmap %lx\n", scr_width, scr_height, pix);
+	return 0;
+}
+
+/* returns the frame top to bottom, as 32bit BGRA pixels */
+static uint32_t *read_frame(int *stride)
+{
+	int i;
+	uint32_t *top, *bot, tmp;
+
+	if(sw_render) {
+		return swr_framebuffer(stride);
+	}
+
+	if(!(readback = malloc(scr_width * scr_height * sizeof *readback))) {
+		fprintf(stderr, "xlivebg: failed to allocate %dx%d frame\n", scr_width, scr_height);
+		return 0;
+	}
+	if(xlivebg_gl_bind_framebuffer) {
+		xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+	}
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, scr_width, scr_height, GL_BGRA, GL_UNSIGNED_BYTE, readback);
+
+	/* OpenGL images are bottom to top */
+	top = readback;
+	bot = readback + (scr_height - 1) * scr_width;
+	while(top < bot) {
+		for(i=0; i<scr_width; i++) {
+			tmp = top[i];
+			top[i] = bot[i];
+			bot[i] = tmp;
+		}
+		top += scr_width;
+		bot -= scr_width;
+	}
+
+	*stride = scr_width;
+	return readback;
+}
+
+static Pixmap create_pixmap(Display *dpy, Window root, uint32_t *pixels, int stride)
+{
+	int i, j, rshift, gshift, bshift, scr = DefaultScreen(dpy);
+	unsigned int depth = DefaultDepth(dpy, scr);
+	Visual *vis = DefaultVisual(dpy, scr);
+	XImage *img;
+	Pixmap pix;
+	GC gc;
+	uint32_t c;
+
+	if(!(img = XCreateImage(dpy, vis, depth, ZPixmap, 0, 0, scr_width, scr_height, 32, 0))) {
+		fprintf(stderr, "xlivebg: failed to create %dx%d image\n", scr_width, scr_height);
+		return 0;
+	}
+	if(!(img->data = malloc(img->bytes_per_line * scr_height))) {
+		fprintf(stderr, "xlivebg: failed to allocate %dx%d image\n", scr_width, scr_height);
+		XDestroyImage(img);
+		return 0;
+	}
+
+	if(img->bits_per_pixel == 32 && vis->red_mask == 0xff0000 && vis->green_mask == 0xff00 &&
+			vis->blue_mask == 0xff && img->byte_order == native_byte_order()) {
+		/* same layout as our pixels */
+		for(i=0; i<scr_height; i++) {
+			memcpy(img->data + i * img->bytes_per_line, pixels + i * stride, scr_width * 4);
+		}
+	} else {
+		rshift = mask_shift(vis->red_mask);
+		gshift = mask_shift(vis->green_mask);
+		bshift = mask_shift(vis->blue_mask);
+
+		for(i=0; i<scr_height; i++) {
+			for(j=0; j<scr_width; j++) {
+				c = pixels[i * stride + j];
+				XPutPixel(img, j, i,
+						((((unsigned long)(c >> 16) & 0xff) << 24 >> rshift) & vis->red_mask) |
+						((((unsigned long)(c >> 8) & 0xff) << 24 >> gshift) & vis->green_mask) |
+						((((unsigned long)c & 0xff) << 24 >> bshift) & vis->blue_mask));
+			}
+		}
+	}
+
+	pix = XCreatePixmap(dpy, root, scr_width, scr_height, depth);
+	gc = XCreateGC(dpy, pix, 0, 0);
+	XPutImage(dpy, pix, gc, img, 0, 0, 0, 0, scr_width, scr_height);
+	XFreeGC(dpy, gc);
+	XDestroyImage(img);
+	return pix;
+}
+
+/* sets pix as the root window background, the way Esetroot does: the pixmap
+ * is kept alive after we disconnect, and the one left by whoever set the
+ * background before us is freed.
+ */
+static void set_root_pixmap(Display *dpy, Window root, Pixmap pix)
+{
+	Atom xa_xroot, xa_eroot, type;
+	int fmt;
+	unsigned long count, rem;
+	unsigned char *xroot_data = 0, *eroot_data = 0;
+
+	xa_xroot = XInternAtom(dpy, "_XROOTPMAP_ID", False);
+	xa_eroot = XInternAtom(dpy, "ESETROOT_PMAP_ID", False);
+
+	XGrabServer(dpy);
+
+	if(XGetWindowProperty(dpy, root, xa_xroot, 0, 1, False, AnyPropertyType, &type, &fmt,
+				&count, &rem, &xroot_data) == Success && type == XA_PIXMAP &&
+			XGetWindowProperty(dpy, root, xa_eroot, 0, 1, False, AnyPropertyType, &type, &fmt,
+				&count, &rem, &eroot_data) == Success && type == XA_PIXMAP) {
+		if(*(Pixmap*)xroot_data == *(Pixmap*)eroot_data) {
+			XKillClient(dpy, *(Pixmap*)xroot_data);
+		}
+	}
+	if(xroot_data) XFree(xroot_data);
+	if(eroot_data) XFree(eroot_data);
+
+	XChangeProperty(dpy, root, xa_xroot, XA_PIXMAP, 32, PropModeReplace, (unsigned char*)&pix, 1);
+	XChangeProperty(dpy, root, xa_eroot, XA_PIXMAP, 32, PropModeReplace, (unsigned char*)&pix, 1);
+	XSetWindowBackgroundPixmap(dpy, root, pix);
+	XClearWindow(dpy, root);
+
+	XUngrabServer(dpy);
+	XSetCloseDownMode(dpy, RetainPermanent);
+	XFlush(dpy);
+}
+
+/* right shift which takes the top 8 bits of a 32bit value to mask */
+static int mask_shift(unsigned long mask)
+{
+	int top = 31;
+
+	if(!mask) return 0;
+	while(!(mask & (1ul << top))) top--;
+	return 31 - top;
+}
+
+static int native_byte_order(void)
+{
+	unsigned int x = 1;
+	return *(unsigned char*)&x ? LSBFirst : MSBFirst;
+}
@@ -0,0 +1,32 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef BAKE_H_
+#define BAKE_H_
+
+#include <X11/Xlib.h>
+
+/* draws a single frame of the active plugin, copies it into a pixmap, and
+ * makes that the background of the root window, published through the
+ * _XROOTPMAP_ID and ESETROOT_PMAP_ID properties for compositors and
+ * pseudo-transparent programs. The pixmap outlives the connection, so xlivebg
+ * can exit right after, leaving nothing running. Expects an OpenGL context
+ * (or the software renderer) to be set up at the size of the root window.
+ */
+int bake_run(Display *dpy, Window root);
+
+#endif	/* BAKE_H_ */
@@ -0,0 +1,129 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <GL/gl.h>
+#include "bench.h"
+#include "app.h"
+#include "plugin.h"
+#include "sched.h"
+#include "timesrc.h"
+
+struct summary {
+	long min, max, avg;
+	long p50, p95, p99;
+};
+
+static void summarize(long *samples, long count, struct summary *res);
+static void print_summary(const char *name, struct summary *sum);
+static int cmp_long(const void *a, const void *b);
+
+int bench_run(const char *plugin_name, long num_frames)
+{
+	long i;
+	long *cpu_usec, *frame_usec;
+	char buf[64];
+	int64_t tbench, t0, t1, t2;
+	struct summary sum;
+	struct xlivebg_plugin *plugin;
+
+	if(!(plugin = get_active_plugin()) || strcmp(plugin->name, plugin_name) != 0) {
+		fprintf(stderr, "bench: failed to activate plugin: %s\n", plugin_name);
+		return -1;
+	}
+
+	if(!(cpu_usec = malloc(num_frames * 2 * sizeof *cpu_usec))) {
+		fprintf(stderr, "bench: failed to allocate sample buffer for %ld frames\n", num_frames);
+		return -1;
+	}
+	frame_usec = cpu_usec + num_frames;
+
+	tbench = sched_time_usec();
+	timesrc_reset(tbench);
+	for(i=0; i<num_frames; i++) {
+		t0 = sched_time_usec();
+		app_frame_time(timesrc_frame(t0));
+
+		app_draw();
+		t1 = sched_time_usec();
+		/* wait for the frame to actually finish, to include the GPU cost */
+		if(!sw_render) {
+			glFinish();
+		}
+		t2 = sched_time_usec();
+
+		cpu_usec[i] = t1 - t0;
+		frame_usec[i] = t2 - t0;
+	}
+	tbench = sched_time_usec() - tbench;
+
+	printf("bench.plugin=%s\n", plugin_name);
+	printf("bench.renderer=%s\n", sw_render ? "software" : (char*)glGetString(GL_RENDERER));
+	printf("bench.width=%d\n", scr_width);
+	printf("bench.height=%d\n", scr_height);
+	printf("bench.frames=%ld\n", num_frames);
+	timesrc_describe(buf, sizeof buf);
+	printf("bench.time=%s\n", buf);
+	printf("bench.total_usec=%ld\n", (long)tbench);
+	printf("bench.fps=%.2f\n", tbench > 0 ? num_frames * 1000000.0 / tbench : 0.0);
+	printf("bench.first_frame_usec=%ld\n", frame_usec[0]);
+
+	summarize(cpu_usec, num_frames, &sum);
+	print_summary("cpu", &sum);
+	summarize(frame_usec, num_frames, &sum);
+	print_summary("frame", &sum);
+
+	free(cpu_usec);
+	return 0;
+}
+
+static void summarize(long *samples, long count, struct summary *res)
+{
+	long i;
+	double sum = 0.0;
+
+	qsort(samples, count, sizeof *samples, cmp_long);
+
+	for(i=0; i<count; i++) {
+		sum += samples[i];
+	}
+	res->min = samples[0];
+	res->max = samples[count - 1];
+	res->avg = (long)(sum / count);
+	res->p50 = samples[(count - 1) * 50 / 100];
+	res->p95 = samples[(count - 1) * 95 / 100];
+	res->p99 = samples[(count - 1) * 99 / 100];
+}
+
+static void print_summary(const char *name, struct summary *sum)
+{
+	printf("bench.%s_usec.min=%ld\n", name, sum->min);
+	printf("bench.%s_usec.avg=%ld\n", name, sum->avg);
+	printf("bench.%s_usec.p50=%ld\n", name, sum->p50);
+	printf("bench.%s_usec.p95=%ld\n", name, sum->p95);
+	printf("bench.%s_usec.p99=%ld\n", name, sum->p99);
+	printf("bench.%s_usec.max=%ld\n", name, sum->max);
+}
+
+static int cmp_long(const void *a, const void *b)
+{
+	long x = *(long*)a;
+	long y = *(long*)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
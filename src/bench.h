@@ -0,0 +1,28 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef BENCH_H_
+#define BENCH_H_
+
+/* draws num_frames frames of the active plugin as fast as possible, with
+ * animation time coming from the current time source (see timesrc.h), and
+ * prints the results to stdout as key=value lines. Expects an OpenGL context
+ * to be current.
+ */
+int bench_run(const char *plugin_name, long num_frames);
+
+#endif	/* BENCH_H_ */
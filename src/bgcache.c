@@ -0,0 +1,246 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "opengl.h"
+#include "bgcache.h"
+#include "app.h"
+#include "cfg.h"
+#include "rscale.h"
+#include "gltrack.h"
+
+static void draw_gradient(int all_screens);
+static void draw_cache(void);
+static int begin_draw(void);
+static void end_draw(int prog);
+static int update_cache(void);
+static int create_target(void);
+static void destroy_target(void);
+
+static unsigned int fbo, tex;
+static int width, height;
+static int valid;
+static int failed;	/* couldn't create the framebuffer at this size, draw directly */
+
+
+void bgcache_draw(void)
+{
+	if(!gl_have_fbo || failed || update_cache() == -1) {
+		draw_gradient(0);
+		return;
+	}
+	draw_cache();
+}
+
+void bgcache_invalidate(void)
+{
+	valid = 0;
+	failed = 0;
+}
+
+void bgcache_destroy_gl(void)
+{
+	destroy_target();
+}
+
+static int update_cache(void)
+{
+	int draw_fbo, read_fbo;
+
+	if(valid && width == rscale_width() && height == rscale_height()) {
+		return 0;
+	}
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &draw_fbo);
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_fbo);
+
+	if(!fbo || width != rscale_width() || height != rscale_height()) {
+		destroy_target();
+		if(create_target() == -1) {
+			failed = 1;
+			return -1;
+		}
+	}
+	xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, fbo);
+
+	glPushAttrib(GL_VIEWPORT_BIT | GL_SCISSOR_BIT | GL_COLOR_BUFFER_BIT);
+	glDisable(GL_SCISSOR_TEST);
+	glClearColor(0, 0, 0, 1);
+	glClear(GL_COLOR_BUFFER_BIT);
+	draw_gradient(1);
+	glPopAttrib();
+
+	xlivebg_gl_bind_framebuffer(GL_DRAW_FRAMEBUFFER, draw_fbo);
+	xlivebg_gl_bind_framebuffer(GL_READ_FRAMEBUFFER, read_fbo);
+
+	valid = 1;
+	return 0;
+}
+
+/* draws the vertical or horizontal gradient over each screen, leaving the
+ * OpenGL state as it was.
+ */
+static void draw_gradient(int all_screens)
+{
+	static float varr[2][24] = {
+		{0, 0, 0, 1, 1, 0, 0, 0, 0, -1, 1, 0, 0, 0, 0, -1, -1, 0, 0, 0, 0, 1, -1, 0},
+		{5, 5, 5, -1, 1, 0, 5, 5, 5, -1, -1, 0, 5, 5, 5, 1, -1, 0, 5, 5, 5, 1, 1, 0}
+	};
+	float *vptr;
+	int i, count, prog;
+	struct xlivebg_screen *scr;
+
+	vptr = varr[cfg.bgmode - 1];
+
+	prog = begin_draw();
+	glDisable(GL_TEXTURE_2D);
+
+	vptr[0] = vptr[6] = cfg.color[0].r;
+	vptr[1] = vptr[7] = cfg.color[0].g;
+	vptr[2] = vptr[8] = cfg.color[0].b;
+	vptr[12] = vptr[18] = cfg.color[1].r;
+	vptr[13] = vptr[19] = cfg.color[1].g;
+	vptr[14] = vptr[20] = cfg.color[1].b;
+
+	glInterleavedArrays(GL_C3F_V3F, 0, vptr);
+
+	count = all_screens ? num_screens : num_vis_screens;
+	for(i=0; i<count; i++) {
+		scr = screen + (all_screens ? i : vis_screen[i]);
+		glViewport(scr->vport[0], scr->vport[1], scr->vport[2], scr->vport[3]);
+		glDrawArrays(GL_QUADS, 0, 4);
+	}
+
+	end_draw(prog);
+}
+
+/* draws the cached gradient over the whole framebuffer, leaving the OpenGL
+ * state as it was. Like a blit, but without touching the framebuffer
+ * bindings, which may belong to the plugin.
+ */
+static void draw_cache(void)
+{
+	static float varr[] = {0, 0, -1, -1, 0, 1, 0, 1, -1, 0, 1, 1, 1, 1, 0, 0, 1, -1, 1, 0};
+	int prog;
+
+	prog = begin_draw();
+	glViewport(0, 0, width, height);
+
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+	glInterleavedArrays(GL_T2F_V3F, 0, varr);
+	glDrawArrays(GL_QUADS, 0, 4);
+
+	end_draw(prog);
+}
+
+/* sets up the state shared by the gradient and the cache: identity matrices,
+ * no lighting, depth test, blending or shaders. Returns the shader program
+ * to give back to end_draw.
+ */
+static int begin_draw(void)
+{
+	int prog = 0;
+
+	glPushAttrib(GL_ENABLE_BIT | GL_TRANSFORM_BIT | GL_VIEWPORT_BIT | GL_TEXTURE_BIT);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glDisable(GL_LIGHTING);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glDisable(GL_TEXTURE_1D);
+
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+	if(xlivebg_gl_use_program) {
+		glGetIntegerv(GL_CURRENT_PROGRAM, &prog);
+		xlivebg_gl_use_program(0);
+	}
+	if(xlivebg_gl_bind_buffer) {
+		xlivebg_gl_bind_buffer(GL_ARRAY_BUFFER, 0);
+	}
+	return prog;
+}
+
+static void end_draw(int prog)
+{
+	glPopClientAttrib();
+	if(prog) {
+		xlivebg_gl_use_program(prog);
+	}
+
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+	glPopAttrib();
+}
+
+static int create_target(void)
+{
+	void *owner;
+	unsigned int status;
+	int w = rscale_width();
+	int h = rscale_height();
+
+	/* the cache belongs to the core, whichever plugin is drawing */
+	owner = gltrack_owner(0);
+	glGenTextures(1, &tex);
+	gltrack_owner(owner);
+
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	xlivebg_gl_gen_framebuffers(1, &fbo);
+	xlivebg_gl_bind_framebuffer(GL_READ_FRAMEBUFFER, fbo);
+	xlivebg_gl_framebuffer_texture_2d(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+	status = xlivebg_gl_check_framebuffer_status(GL_READ_FRAMEBUFFER);
+
+	if(status != GL_FRAMEBUFFER_COMPLETE) {
+		fprintf(stderr, "xlivebg: failed to create %dx%d background framebuffer (status: %x)\n",
+				w, h, status);
+		destroy_target();
+		return -1;
+	}
+	width = w;
+	height = h;
+	return 0;
+}
+
+static void destroy_target(void)
+{
+	if(fbo) {
+		xlivebg_gl_delete_framebuffers(1, &fbo);
+		fbo = 0;
+	}
+	if(tex) {
+		glDeleteTextures(1, &tex);
+		tex = 0;
+	}
+	width = height = 0;
+	valid = 0;
+}
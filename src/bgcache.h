@@ -0,0 +1,39 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef BGCACHE_H_
+#define BGCACHE_H_
+
+/* Background gradient cache for xlivebg_clear. The gradient of every screen
+ * is rendered once into a texture, through an offscreen framebuffer, and
+ * drawn over the current framebuffer each time it's needed, as a single quad,
+ * without touching any other OpenGL state. The cache is rebuilt when the
+ * background colors or mode, or the screen layout change. Falls back to
+ * drawing the gradient directly, if framebuffer objects aren't available.
+ */
+
+/* fills the visible screens with the background gradient. Honors the
+ * scissor test, like glClear.
+ */
+void bgcache_draw(void);
+
+/* forces the gradient to be rendered again, next time it's needed */
+void bgcache_invalidate(void);
+
+void bgcache_destroy_gl(void);
+
+#endif	/* BGCACHE_H_ */
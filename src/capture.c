@@ -0,0 +1,404 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include "opengl.h"
+#include "capture.h"
+#include "app.h"
+#include "sched.h"
+#include "swrender.h"
+
+/* frames in flight between glReadPixels and mapping the buffer */
+#define NUM_PBO		3
+/* frames waiting to be written to disk */
+#define MAX_QUEUED	8
+
+struct frame {
+	unsigned char *pixels;	/* BGRA */
+	int flip;				/* bottom-up, as read back from OpenGL */
+	unsigned long num;
+	int64_t time, anim;
+	struct frame *next;
+};
+
+struct readback {
+	unsigned int pbo;
+	int pending;
+	unsigned long num;
+	int64_t time, anim;
+};
+
+static struct frame *get_frame(void);
+static void queue_frame(struct frame *frm);
+static void read_pixels(void *dest);
+static void fetch(struct readback *rb);
+static void *writer(void *cls);
+static void write_frame(struct frame *frm);
+
+static FILE *fp;
+static char *path;
+static int width, height;
+static long frame_size;
+static int64_t start_time;
+static unsigned long frame_num, num_written, num_dropped;
+
+static struct readback ring[NUM_PBO];
+static int use_pbo, cur_rb;
+
+static struct frame frames[MAX_QUEUED];
+static unsigned char *frame_mem, *planes;
+static struct frame *freelist, *queue, *queue_tail;
+static pthread_t thread;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static int quit_writer, write_failed;
+
+
+int capture_start(const char *fname)
+{
+	int i;
+	long interval;
+
+	if(fp) {
+		fprintf(stderr, "capture: already capturing to %s\n", path);
+		return -1;
+	}
+	width = scr_width;
+	height = scr_height;
+	if(width <= 0 || height <= 0) {
+		fprintf(stderr, "capture: nothing to capture\n");
+		return -1;
+	}
+	frame_size = (long)width * height * 4;
+
+	if(!(frame_mem = malloc(frame_size * MAX_QUEUED + (long)width * height * 3))) {
+		fprintf(stderr, "capture: failed to allocate frame buffers\n");
+		return -1;
+	}
+	planes = frame_mem + frame_size * MAX_QUEUED;
+
+	if(!(path = strdup(fname)) || !(fp = fopen(fname, "wb"))) {
+		fprintf(stderr, "capture: failed to open %s: %s\n", fname, strerror(errno));
+		free(path);
+		path = 0;
+		free(frame_mem);
+		return -1;
+	}
+
+	if((interval = sched_interval()) <= 0) {
+		interval = 1000000 / 60;
+	}
+	fprintf(fp, "YUV4MPEG2 W%d H%d F1000000:%ld Ip A1:1 C444 XCOLORRANGE=FULL\n",
+			width, height, interval);
+
+	freelist = queue = queue_tail = 0;
+	for(i=0; i<MAX_QUEUED; i++) {
+		frames[i].pixels = frame_mem + i * frame_size;
+		frames[i].next = freelist;
+		freelist = frames + i;
+	}
+	start_time = -1;
+	frame_num = num_written = num_dropped = 0;
+	write_failed = 0;
+
+	use_pbo = !sw_render && gl_have_pbo;
+	if(use_pbo) {
+		for(i=0; i<NUM_PBO; i++) {
+			xlivebg_gl_gen_buffers(1, &ring[i].pbo);
+			xlivebg_gl_bind_buffer(GL_PIXEL_PACK_BUFFER, ring[i].pbo);
+			xlivebg_gl_buffer_data(GL_PIXEL_PACK_BUFFER, frame_size, 0, GL_STREAM_READ);
+			ring[i].pending = 0;
+		}
+		xlivebg_gl_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+		cur_rb = 0;
+	}
+
+	quit_writer = 0;
+	if(pthread_create(&thread, 0, writer, 0) != 0) {
+		fprintf(stderr, "capture: failed to start writer thread\n");
+		if(use_pbo) {
+			for(i=0; i<NUM_PBO; i++) {
+				xlivebg_gl_delete_buffers(1, &ring[i].pbo);
+			}
+		}
+		fclose(fp);
+		fp = 0;
+		free(path);
+		path = 0;
+		free(frame_mem);
+		return -1;
+	}
+
+	printf("capture: writing %dx%d frames to %s (%s readback)\n", width, height, path,
+			sw_render ? "software" : (use_pbo ? "asynchronous" : "synchronous"));
+	return 0;
+}
+
+void capture_stop(void)
+{
+	int i;
+	struct readback *rb;
+
+	if(!fp) return;
+
+	/* flush the frames still in flight, oldest first */
+	if(use_pbo) {
+		for(i=0; i<NUM_PBO; i++) {
+			rb = ring + (cur_rb + i) % NUM_PBO;
+			if(rb->pending) {
+				fetch(rb);
+			}
+			xlivebg_gl_delete_buffers(1, &rb->pbo);
+		}
+	}
+
+	pthread_mutex_lock(&lock);
+	quit_writer = 1;
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&lock);
+	pthread_join(thread, 0);
+
+	if(fclose(fp) == -1 && !write_failed) {
+		fprintf(stderr, "capture: failed to write %s: %s\n", path, strerror(errno));
+	}
+	fp = 0;
+	printf("capture: wrote %lu frames to %s (%lu dropped)\n", num_written, path, num_dropped);
+
+	free(path);
+	path = 0;
+	free(frame_mem);
+	frame_mem = planes = 0;
+}
+
+const char *capture_path(void)
+{
+	return path;
+}
+
+void capture_status(unsigned long *written, unsigned long *dropped)
+{
+	pthread_mutex_lock(&lock);
+	*written = num_written;
+	*dropped = num_dropped;
+	pthread_mutex_unlock(&lock);
+}
+
+void capture_frame(int64_t now)
+{
+	int i, stride;
+	uint32_t *pixels;
+	struct frame *frm;
+	struct readback *rb;
+
+	if(!fp) return;
+
+	if(scr_width != width || scr_height != height) {
+		fprintf(stderr, "capture: output size changed, stopping\n");
+		capture_stop();
+		return;
+	}
+	if(start_time < 0) {
+		start_time = now;
+	}
+
+	if(use_pbo) {
+		/* the oldest readback in the ring should be done by now */
+		rb = ring + cur_rb;
+		if(rb->pending) {
+			fetch(rb);
+		}
+
+		xlivebg_gl_bind_buffer(GL_PIXEL_PACK_BUFFER, rb->pbo);
+		read_pixels(0);
+		xlivebg_gl_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		rb->pending = 1;
+		rb->num = frame_num++;
+		rb->time = now - start_time;
+		rb->anim = frame_time_usec;
+		cur_rb = (cur_rb + 1) % NUM_PBO;
+		return;
+	}
+
+	if((frm = get_frame())) {
+		if(sw_render) {
+			pixels = swr_framebuffer(&stride);
+			for(i=0; i<height; i++) {
+				memcpy(frm->pixels + i * width * 4, pixels + i * stride, width * 4);
+			}
+			frm->flip = 0;
+		} else {
+			read_pixels(frm->pixels);
+			frm->flip = 1;
+		}
+		frm->num = frame_num;
+		frm->time = now - start_time;
+		frm->anim = frame_time_usec;
+		queue_frame(frm);
+	}
+	frame_num++;
+}
+
+/* returns a free frame buffer, or null (and counts a dropped frame) if they're
+ * all waiting to be written.
+ */
+static struct frame *get_frame(void)
+{
+	struct frame *frm;
+
+	pthread_mutex_lock(&lock);
+	if((frm = freelist)) {
+		freelist = frm->next;
+	} else {
+		num_dropped++;
+	}
+	pthread_mutex_unlock(&lock);
+	return frm;
+}
+
+static void queue_frame(struct frame *frm)
+{
+	frm->next = 0;
+
+	pthread_mutex_lock(&lock);
+	if(queue) {
+		queue_tail->next = frm;
+	} else {
+		queue = frm;
+	}
+	queue_tail = frm;
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&lock);
+}
+
+/* reads the window framebuffer into dest, or the bound pixel pack buffer */
+static void read_pixels(void *dest)
+{
+	int fbo = 0;
+
+	if(xlivebg_gl_bind_framebuffer) {
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &fbo);
+		if(fbo) xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, dest);
+
+	if(fbo) {
+		xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, fbo);
+	}
+}
+
+static void fetch(struct readback *rb)
+{
+	void *src;
+	struct frame *frm;
+
+	rb->pending = 0;
+	if(!(frm = get_frame())) {
+		return;
+	}
+
+	xlivebg_gl_bind_buffer(GL_PIXEL_PACK_BUFFER, rb->pbo);
+	if((src = xlivebg_gl_map_buffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY))) {
+		memcpy(frm->pixels, src, frame_size);
+		xlivebg_gl_unmap_buffer(GL_PIXEL_PACK_BUFFER);
+	}
+	xlivebg_gl_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if(!src) {
+		pthread_mutex_lock(&lock);
+		frm->next = freelist;
+		freelist = frm;
+		num_dropped++;
+		pthread_mutex_unlock(&lock);
+		return;
+	}
+
+	frm->flip = 1;
+	frm->num = rb->num;
+	frm->time = rb->time;
+	frm->anim = rb->anim;
+	queue_frame(frm);
+}
+
+/* writer thread: writes queued frames until told to quit, and the queue is empty */
+static void *writer(void *cls)
+{
+	struct frame *frm;
+
+	pthread_mutex_lock(&lock);
+	for(;;) {
+		while(!queue && !quit_writer) {
+			pthread_cond_wait(&cond, &lock);
+		}
+		if(!(frm = queue)) break;
+
+		if(!(queue = frm->next)) {
+			queue_tail = 0;
+		}
+		pthread_mutex_unlock(&lock);
+
+		write_frame(frm);
+
+		pthread_mutex_lock(&lock);
+		frm->next = freelist;
+		freelist = frm;
+		num_written++;
+	}
+	pthread_mutex_unlock(&lock);
+	return 0;
+}
+
+#define CLAMP255(x)	((x) > 255 ? 255 : (x))
+
+/* converts a frame to full range BT.601 YCbCr planes, and writes it out */
+static void write_frame(struct frame *frm)
+{
+	int i, j, r, g, b;
+	unsigned char *src, *yptr, *cbptr, *crptr;
+	long plane_size = (long)width * height;
+
+	yptr = planes;
+	cbptr = planes + plane_size;
+	crptr = cbptr + plane_size;
+
+	for(i=0; i<height; i++) {
+		src = frm->pixels + (frm->flip ? height - 1 - i : i) * width * 4;
+		for(j=0; j<width; j++) {
+			b = src[0];
+			g = src[1];
+			r = src[2];
+			src += 4;
+
+			*yptr++ = (19595 * r + 38470 * g + 7471 * b + 32768) >> 16;
+			*cbptr++ = CLAMP255((-11059 * r - 21709 * g + 32768 * b + 8421376) >> 16);
+			*crptr++ = CLAMP255((32768 * r - 27439 * g - 5329 * b + 8421376) >> 16);
+		}
+	}
+
+	fprintf(fp, "FRAME Xframe=%lu Xtime=%ld Xanim=%ld\n", frm->num, (long)frm->time,
+			(long)frm->anim);
+	if(fwrite(planes, 1, plane_size * 3, fp) < plane_size * 3 && !write_failed) {
+		fprintf(stderr, "capture: failed to write %s: %s\n", path, strerror(errno));
+		write_failed = 1;
+	}
+}
@@ -0,0 +1,47 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+#include <inttypes.h>
+
+/* Frame capture: streams every presented frame to a YUV4MPEG2 file (4:4:4,
+ * full range), for visual regression tests and frame pacing analysis. With
+ * OpenGL, frames are read back asynchronously through a ring of pixel buffer
+ * objects, and then converted and written to disk by a separate thread, so
+ * the render loop never waits for the GPU or the disk. Each frame header
+ * carries the frame number, the time the frame was presented (relative to the
+ * first captured frame), and its animation time, in microseconds:
+ *
+ *   FRAME Xframe=<n> Xtime=<usec> Xanim=<usec>
+ *
+ * Frames are dropped if the writer thread falls behind, and show up as gaps in
+ * the frame numbers.
+ */
+int capture_start(const char *fname);
+void capture_stop(void);
+
+/* returns the file being written, or null if there's no capture in progress */
+const char *capture_path(void);
+/* frames written and dropped by the current (or last) capture */
+void capture_status(unsigned long *written, unsigned long *dropped);
+
+/* called after drawing each frame, right before it's presented */
+void capture_frame(int64_t now);
+
+#endif	/* CAPTURE_H_ */
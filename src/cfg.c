@@ -5,6 +5,8 @@
 #include "cfg.h"
 #include "util.h"
 
+static struct ts_node *find_output(int idx, const char *name);
+
 struct cfg cfg;
 char *cfgpath;
 
@@ -18,6 +20,12 @@ void init_cfg(void)
 	/* init default state */
 	memset(&cfg, 0, sizeof cfg);
 	cfg.fps_override = -1;
+	cfg.power_idle_fps = DEF_POWER_IDLE_FPS;
+	cfg.cleanup_after = DEF_CLEANUP_AFTER;
+	cfg.quality_budget = DEF_QUALITY_BUDGET;
+	cfg.isolate_timeout = DEF_ISOLATE_TIMEOUT;
+	cfg.render_scale = 1.0f;
+	cfg.loop_budget = DEF_LOOP_BUDGET;
 
 	/* load a config file if there is one */
 	if(!(cfgpath = get_config_path())) {
@@ -73,6 +81,18 @@ void init_cfg(void)
 	cfg.crop_dir[0] = vec[0];
 	cfg.crop_dir[1] = vec[1];
 
+	cfg.power_idle_after = ts_lookup_int(ts, CFGNAME_POWER_IDLE_AFTER, 0);
+	cfg.power_idle_fps = ts_lookup_int(ts, CFGNAME_POWER_IDLE_FPS, DEF_POWER_IDLE_FPS);
+	cfg.cleanup_after = ts_lookup_int(ts, CFGNAME_CLEANUP_AFTER, DEF_CLEANUP_AFTER);
+	cfg.quality_budget = ts_lookup_int(ts, CFGNAME_QUALITY_BUDGET, DEF_QUALITY_BUDGET);
+	cfg.sw_threads = ts_lookup_int(ts, CFGNAME_SW_THREADS, 0);
+	cfg.isolate = ts_lookup_int(ts, CFGNAME_ISOLATE, 0);
+	cfg.isolate_timeout = ts_lookup_int(ts, CFGNAME_ISOLATE_TIMEOUT, DEF_ISOLATE_TIMEOUT);
+	cfg.render_scale = ts_lookup_num(ts, CFGNAME_RENDER_SCALE, 1.0f);
+	cfg.static_detect = ts_lookup_int(ts, CFGNAME_STATIC_DETECT, 0);
+	cfg.loop_budget = ts_lookup_int(ts, CFGNAME_LOOP_BUDGET, DEF_LOOP_BUDGET);
+	cfg.loop_compress = ts_lookup_int(ts, CFGNAME_LOOP_COMPRESS, 0);
+
 	cfg.ts = ts;
 }
 
@@ -81,6 +101,42 @@ int save_cfg(const char *fname)
 	return ts_save(cfg.ts, fname ? fname : get_save_config_path());
 }
 
+int cfg_output_fps(int idx, const char *name)
+{
+	struct ts_node *node = find_output(idx, name);
+	return node ? ts_get_attr_int(node, "fps", -1) : -1;
+}
+
+float cfg_output_scale(int idx, const char *name)
+{
+	struct ts_node *node = find_output(idx, name);
+	return node ? ts_get_attr_num(node, "scale", -1.0f) : -1.0f;
+}
+
+/* finds the output section of an output, matching it by name, or by index */
+static struct ts_node *find_output(int idx, const char *name)
+{
+	struct ts_node *node;
+	const char *str;
+
+	if(!cfg.ts) return 0;
+
+	node = cfg.ts->child_list;
+	while(node) {
+		if(strcmp(node->name, "output") == 0) {
+			if((str = ts_get_attr_str(node, "name", 0))) {
+				if(name && strcmp(str, name) == 0) {
+					return node;
+				}
+			} else if(ts_get_attr_int(node, "index", -1) == idx) {
+				return node;
+			}
+		}
+		node = node->next;
+	}
+	return 0;
+}
+
 int cfg_parse_fit(const char *str)
 {
 	if(strcasecmp(str, "full") == 0) {
@@ -31,6 +31,17 @@ struct cfg {
 	int fit;
 	float zoom;
 	float crop_dir[2];
+	int power_idle_after;	/* seconds of inactivity before throttling (0: never) */
+	int power_idle_fps;		/* framerate while idle (0: stop drawing) */
+	int cleanup_after;		/* seconds before inactive plugins are cleaned up (0: never) */
+	int quality_budget;		/* frame time budget in milliseconds for adaptive quality (0: off) */
+	int sw_threads;			/* software rendering threads (0: one per CPU) */
+	int isolate;			/* run the active plugin in a separate host process */
+	int isolate_timeout;	/* milliseconds before a hung plugin host is restarted */
+	float render_scale;		/* resolution scale of what plugins draw, upscaled to the outputs */
+	int static_detect;		/* identical frames before the output is considered static (0: off) */
+	int loop_budget;		/* memory for cached loop frames in MB (0: off) */
+	int loop_compress;		/* store cached loop frames DXT1 compressed, if supported */
 
 	struct ts_node *ts;
 };
@@ -48,10 +59,34 @@ extern char *cfgpath;
 #define CFGNAME_FIT			"xlivebg.fit"
 #define CFGNAME_CROP_ZOOM	"xlivebg.crop_zoom"
 #define CFGNAME_CROP_DIR	"xlivebg.crop_dir"
+#define CFGNAME_POWER_IDLE_AFTER	"xlivebg.power.idle_after"
+#define CFGNAME_POWER_IDLE_FPS		"xlivebg.power.idle_fps"
+#define CFGNAME_CLEANUP_AFTER	"xlivebg.cleanup_after"
+#define CFGNAME_QUALITY_BUDGET	"xlivebg.quality.budget"
+#define CFGNAME_SW_THREADS		"xlivebg.sw.threads"
+#define CFGNAME_ISOLATE			"xlivebg.isolate.enable"
+#define CFGNAME_ISOLATE_TIMEOUT	"xlivebg.isolate.timeout"
+#define CFGNAME_RENDER_SCALE	"xlivebg.render_scale"
+#define CFGNAME_STATIC_DETECT	"xlivebg.static_detect"
+#define CFGNAME_LOOP_BUDGET		"xlivebg.loop_cache.budget"
+#define CFGNAME_LOOP_COMPRESS	"xlivebg.loop_cache.compress"
+
+#define DEF_POWER_IDLE_FPS	5
+#define DEF_CLEANUP_AFTER	300
+#define DEF_QUALITY_BUDGET	10
+#define DEF_ISOLATE_TIMEOUT	2000
+#define DEF_LOOP_BUDGET		256
 
 void init_cfg(void);
 int save_cfg(const char *fname);
 
+/* framerate of an output, from the output sections of the config file.
+ * Outputs are matched by name, or by index. Returns -1 if not specified.
+ */
+int cfg_output_fps(int idx, const char *name);
+/* render scale of an output, overriding render_scale. Returns -1 if not specified */
+float cfg_output_scale(int idx, const char *name);
+
 int cfg_parse_fit(const char *str);
 int cfg_parse_bgmode(const char *str);
 
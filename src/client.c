@@ -36,10 +36,11 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 static int cmd_generic(int argc, char **argv);
 static int cmd_getupd(int argc, char **argv);
-static int cmd_list(int argc, char **argv);
+static int cmd_lines(int argc, char **argv);
 static int cmd_lsprop(int argc, char **argv);
 static int cmd_setprop(int argc, char **argv);
 static int cmd_getprop(int argc, char **argv);
+static int cmd_capture(int argc, char **argv);
 
 static int read_line(int fd, char *line, int maxsz);
 
@@ -53,11 +54,15 @@ static struct {
 	{"ping", cmd_generic},
 	{"save", cmd_generic},
 	{"getupd", cmd_getupd},
-	{"list", cmd_list},
+	{"list", cmd_lines},
 	{"switch", cmd_generic},
 	{"lsprop", cmd_lsprop},
 	{"setprop", cmd_setprop},
 	{"getprop", cmd_getprop},
+	{"power", cmd_lines},
+	{"stats", cmd_lines},
+	{"time", cmd_lines},
+	{"capture", cmd_capture},
 	{0, 0}
 };
 
@@ -165,20 +170,35 @@ static int cmd_getupd(int argc, char **argv)
 	return 0;
 }
 
-static int cmd_list(int argc, char **argv)
+/* for commands which respond with a line count, followed by that many lines
+ * of text to be printed verbatim
+ */
+static int cmd_lines(int argc, char **argv)
 {
+	int i, len = 0;
 	int state = 0;
 	int num_lines = 0;
 	char buf[256];
-	char *endp;
+	char *endp, *cmdstr, *ptr;
+
+	for(i=1; i<argc; i++) {
+		len += strlen(argv[i]) + 1;
+	}
+	ptr = cmdstr = alloca(len + 1);
+
+	for(i=1; i<argc; i++) {
+		ptr += sprintf(ptr, "%s ", argv[i]);
+	}
+	ptr[-1] = '\n';
+	*ptr = 0;
 
-	write(sock, "list\n", 5);
+	write(sock, cmdstr, len);
 
 	while(read_line(sock, buf, sizeof buf) >= 0) {
 		switch(state) {
 		case 0:
 			if(strcmp(buf, "OK!\n") != 0) {
-				fprintf(stderr, "List command failed\n");
+				fprintf(stderr, "Command %s failed\n", argv[1]);
 				return -1;
 			}
 			state++;
@@ -187,9 +207,10 @@ static int cmd_list(int argc, char **argv)
 		case 1:
 			num_lines = strtol(buf, &endp, 10);
 			if(endp == buf) {
-				fprintf(stderr, "Got invalid response to list command!\n");
+				fprintf(stderr, "Got invalid response to %s command!\n", argv[1]);
 				return -1;
 			}
+			if(num_lines <= 0) return 0;
 			state++;
 			break;
 
@@ -334,6 +355,23 @@ static char inbuf[1024];
 static char *inbuf_head = inbuf;
 static char *inbuf_tail = inbuf;
 
+static int cmd_capture(int argc, char **argv)
+{
+	char *path, cwd[1024];
+
+	/* relative paths are relative to our working directory, not xlivebg's */
+	if(argc > 3 && strcmp(argv[2], "start") == 0 && argv[3][0] != '/') {
+		if(!getcwd(cwd, sizeof cwd)) {
+			fprintf(stderr, "capture: failed to get the current directory: %s\n", strerror(errno));
+			return -1;
+		}
+		path = alloca(strlen(cwd) + strlen(argv[3]) + 2);
+		sprintf(path, "%s/%s", cwd, argv[3]);
+		argv[3] = path;
+	}
+	return cmd_lines(argc, argv);
+}
+
 static int read_line(int fd, char *line, int maxsz)
 {
 	int rd;
@@ -396,5 +434,11 @@ static void print_usage(void)
 	printf("  lsprop [name]: list properties of named or current live wallpaper\n");
 	printf("  setprop <type> <property> <value>: sets a property\n");
 	printf("  getprop <type>: prints the current value of a property\n");
+	printf("  power: print the power management state and user idle time\n");
+	printf("  stats [reset]: print frame timing statistics, or reset them\n");
+	printf("  time [src]: print or change the animation time source. One of: real,\n");
+	printf("        fixed, fixed:<usec>, scale:<factor>\n");
+	printf("  capture [start <file>|stop]: print the state of frame capture, start\n");
+	printf("        writing every frame to a Y4M file, or stop\n");
 	printf("  help: print usage and exit\n");
 }
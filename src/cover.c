@@ -0,0 +1,209 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include "cover.h"
+#include "app.h"
+
+static void track_active(void);
+static int is_fullscreen(Window w);
+static void trap_errors(void);
+static int untrap_errors(void);
+
+static Display *dpy;
+static Window root, ourwin, active;
+static Atom xa_active, xa_state, xa_fullscr, xa_hidden;
+static int initialized;
+
+static int xerr;
+static int (*prev_handler)(Display*, XErrorEvent*);
+
+
+void cover_init(Display *d, Window r, Window w)
+{
+	XWindowAttributes attr;
+
+	dpy = d;
+	root = r;
+	ourwin = w;
+
+	xa_active = XInternAtom(dpy, "_NET_ACTIVE_WINDOW", False);
+	xa_state = XInternAtom(dpy, "_NET_WM_STATE", False);
+	xa_fullscr = XInternAtom(dpy, "_NET_WM_STATE_FULLSCREEN", False);
+	xa_hidden = XInternAtom(dpy, "_NET_WM_STATE_HIDDEN", False);
+
+	/* don't clobber any event mask we might have already selected on root */
+	XGetWindowAttributes(dpy, root, &attr);
+	XSelectInput(dpy, root, attr.your_event_mask | PropertyChangeMask);
+
+	initialized = 1;
+	track_active();
+	cover_update();
+}
+
+int cover_xevent(XEvent *ev)
+{
+	Window w = ev->xany.window;
+
+	if(!initialized) return 0;
+
+	switch(ev->type) {
+	case PropertyNotify:
+		if(w == root && ev->xproperty.atom == xa_active) {
+			track_active();
+			cover_update();
+		} else if(w == active && w != ourwin && ev->xproperty.atom == xa_state) {
+			cover_update();
+		}
+		break;
+
+	case ConfigureNotify:
+	case MapNotify:
+		if(ev->xany.window != active) return 0;
+		cover_update();
+		break;
+
+	case UnmapNotify:
+		if(ev->xunmap.window != active) return 0;
+		cover_update();
+		break;
+
+	case DestroyNotify:
+		if(ev->xdestroywindow.window != active) return 0;
+		active = 0;
+		cover_update();
+		break;
+
+	default:
+		return 0;
+	}
+
+	/* consume events which are not about our own window */
+	return w != ourwin;
+}
+
+void cover_update(void)
+{
+	int i, x, y;
+	unsigned int hidden = 0;
+	Window child;
+	XWindowAttributes attr;
+	struct xlivebg_screen *scr;
+
+	if(active && active != ourwin && is_fullscreen(active)) {
+		trap_errors();
+		XGetWindowAttributes(dpy, active, &attr);
+		XTranslateCoordinates(dpy, active, root, 0, 0, &x, &y, &child);
+		if(untrap_errors() == 0 && attr.map_state == IsViewable) {
+			for(i=0; i<num_screens; i++) {
+				scr = screen + i;
+				if(x <= scr->x && y <= scr->y && x + attr.width >= scr->x + scr->width &&
+						y + attr.height >= scr->y + scr->height) {
+					hidden |= 1u << i;
+				}
+			}
+		}
+	}
+
+	update_visible_screens(hidden);
+}
+
+static void track_active(void)
+{
+	Window newact = 0;
+	Atom type;
+	int fmt;
+	unsigned long count, rem;
+	unsigned char *prop = 0;
+
+	if(XGetWindowProperty(dpy, root, xa_active, 0, 1, False, XA_WINDOW, &type, &fmt,
+				&count, &rem, &prop) == Success && prop) {
+		if(type == XA_WINDOW && fmt == 32 && count > 0) {
+			newact = *(Window*)prop;
+		}
+		XFree(prop);
+	}
+
+	if(newact == active) return;
+
+	trap_errors();
+	if(active && active != ourwin) {
+		XSelectInput(dpy, active, 0);
+	}
+	if(newact && newact != ourwin) {
+		XSelectInput(dpy, newact, PropertyChangeMask | StructureNotifyMask);
+	}
+	if(untrap_errors() != 0) {
+		newact = 0;	/* window went away before we could track it */
+	}
+	active = newact;
+}
+
+static int is_fullscreen(Window w)
+{
+	int i, res = 0;
+	Atom type, *state;
+	int fmt;
+	unsigned long count, rem;
+	unsigned char *prop = 0;
+
+	trap_errors();
+	if(XGetWindowProperty(dpy, w, xa_state, 0, 64, False, XA_ATOM, &type, &fmt,
+				&count, &rem, &prop) == Success && prop) {
+		if(type == XA_ATOM && fmt == 32) {
+			state = (Atom*)prop;
+			for(i=0; i<(int)count; i++) {
+				if(state[i] == xa_hidden) {
+					res = 0;
+					break;
+				}
+				if(state[i] == xa_fullscr) {
+					res = 1;
+				}
+			}
+		}
+		XFree(prop);
+	}
+	if(untrap_errors() != 0) {
+		return 0;
+	}
+	return res;
+}
+
+/* foreign windows may disappear at any time, so any requests on them must be
+ * done with a temporary error handler, to avoid Xlib aborting on BadWindow.
+ */
+static int trap_handler(Display *dpy, XErrorEvent *ev)
+{
+	xerr = ev->error_code;
+	return 0;
+}
+
+static void trap_errors(void)
+{
+	xerr = 0;
+	prev_handler = XSetErrorHandler(trap_handler);
+}
+
+static int untrap_errors(void)
+{
+	XSync(dpy, False);
+	XSetErrorHandler(prev_handler);
+	return xerr;
+}
@@ -0,0 +1,38 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef COVER_H_
+#define COVER_H_
+
+#include <X11/Xlib.h>
+
+/* Tracks the active window through _NET_ACTIVE_WINDOW, and when it's in
+ * _NET_WM_STATE_FULLSCREEN, figures out which outputs it fully covers, so that
+ * we can avoid drawing what nobody can see.
+ */
+
+void cover_init(Display *dpy, Window root, Window ourwin);
+
+/* Handles events related to coverage tracking. Returns 1 if the event was
+ * consumed (it was about a window other than ours), 0 otherwise.
+ */
+int cover_xevent(XEvent *ev);
+
+/* re-evaluates output coverage, and updates the list of visible screens */
+void cover_update(void);
+
+#endif	/* COVER_H_ */
@@ -29,32 +29,35 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <sys/un.h>
 #include "app.h"
 #include "ctrl.h"
+#include "evloop.h"
 #include "plugin.h"
 #include "cfg.h"
 #include "util.h"
+#include "power.h"
+#include "stats.h"
+#include "timesrc.h"
+#include "capture.h"
 
 
 struct client {
 	int s;
 	char inbuf[4096];
 	char *inp;
+	struct client *next;
 };
 
-#define MAX_CLIENTS	16
-static struct client clients[MAX_CLIENTS];
+static struct client *clients;
 static int lis = -1;
 
+static void accept_conn(int s, void *cls);
+static void client_input(int s, void *cls);
+static void close_client(struct client *c);
 static void proc_cmd(int s, char *cmdstr);
 
 int ctrl_init(void)
 {
-	int i;
 	struct sockaddr_un addr;
 
-	for(i=0; i<MAX_CLIENTS; i++) {
-		clients[i].s = -1;
-	}
-
 	if(lis >= 0) {
 		fprintf(stderr, "ctrl_init: already initialized!\n");
 		return -1;
@@ -75,6 +78,12 @@ int ctrl_init(void)
 	}
 	listen(lis, 8);
 
+	if(evloop_add(lis, accept_conn, 0) == -1) {
+		close(lis);
+		lis = -1;
+		remove(SOCK_PATH);
+		return -1;
+	}
 	return 0;
 }
 
@@ -82,73 +91,69 @@ void ctrl_shutdown(void)
 {
 	if(lis == -1) return;
 
+	while(clients) {
+		close_client(clients);
+	}
+
+	evloop_remove(lis);
 	close(lis);
 	lis = -1;
 	remove(SOCK_PATH);
 }
 
-int *ctrl_sockets(int *count)
+static void accept_conn(int s, void *cls)
 {
-	static int sock[MAX_CLIENTS];
-	int i, n = 0;
+	struct client *c;
 
-	if(lis == -1) {
-		*count = 0;
-		return 0;
+	if((s = accept(lis, 0, 0)) == -1) {
+		perror("ctrl: failed to accept incoming connection");
+		return;
 	}
+	fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK);
 
-	sock[n++] = lis;
-	for(i=0; i<MAX_CLIENTS; i++) {
-		if(clients[i].s >= 0) {
-			sock[n++] = clients[i].s;
-		}
+	if(!(c = malloc(sizeof *c))) {
+		perror("ctrl: failed to allocate client");
+		close(s);
+		return;
 	}
-	*count = n;
-	return sock;
-}
-
-void ctrl_process(int s)
-{
-	int i, len;
-	struct client *c;
-	char buf[1024];
-	char *ptr;
-
-	if(s == lis) {
-		c = 0;
-		for(i=0; i<MAX_CLIENTS; i++) {
-			if(clients[i].s == -1) {
-				c = clients + i;
-				break;
-			}
-		}
-		if(!c) {
-			fprintf(stderr, "ctrl_process: too many incoming connections\n");
-			return;
-		}
+	c->s = s;
+	c->inp = c->inbuf;
 
-		if((s = accept(lis, 0, 0)) == -1) {
-			perror("ctrl_process: failed to accept incoming connection");
-			return;
-		}
-		fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK);
-
-		c->s = s;
-		c->inp = c->inbuf;
+	if(evloop_add(s, client_input, c) == -1) {
+		close(s);
+		free(c);
 		return;
 	}
+	c->next = clients;
+	clients = c;
+}
+
+static void close_client(struct client *c)
+{
+	struct client dummy, *prev;
 
-	c = 0;
-	for(i=0; i<MAX_CLIENTS; i++) {
-		if(s == clients[i].s) {
-			c = clients + i;
+	dummy.next = clients;
+	prev = &dummy;
+	while(prev->next) {
+		if(prev->next == c) {
+			prev->next = c->next;
 			break;
 		}
+		prev = prev->next;
 	}
-	if(!c) {
-		fprintf(stderr, "ctrl_process: unknown client socket (%d)\n", s);
-		return;
-	}
+	clients = dummy.next;
+
+	evloop_remove(c->s);
+	close(c->s);
+	free(c);
+}
+
+static void client_input(int s, void *cls)
+{
+	int i, len;
+	struct client *c = cls;
+	char buf[1024];
+	char *ptr;
 
 	while((len = read(s, buf, sizeof buf)) > 0) {
 		ptr = c->inp;
@@ -166,9 +171,8 @@ void ctrl_process(int s)
 		c->inp = ptr;
 	}
 
-	if(len == 0) {
-		close(s);
-		c->s = -1;
+	if(len == 0 || (len == -1 && errno != EAGAIN && errno != EINTR)) {
+		close_client(c);
 	}
 }
 
@@ -187,6 +191,10 @@ static int proc_cmd_save(int s, int argc, char **argv);
 static int proc_cmd_cfgpath(int s, int argc, char **argv);
 static int proc_cmd_ping(int s, int argc, char **argv);
 static int proc_cmd_getupd(int s, int argc, char **argv);
+static int proc_cmd_power(int s, int argc, char **argv);
+static int proc_cmd_stats(int s, int argc, char **argv);
+static int proc_cmd_time(int s, int argc, char **argv);
+static int proc_cmd_capture(int s, int argc, char **argv);
 
 struct {
 	const char *cmd;
@@ -208,6 +216,10 @@ struct {
 	{"cfgpath", proc_cmd_cfgpath},
 	{"ping", proc_cmd_ping},
 	{"getupd", proc_cmd_getupd},
+	{"power", proc_cmd_power},
+	{"stats", proc_cmd_stats},
+	{"time", proc_cmd_time},
+	{"capture", proc_cmd_capture},
 	{0, 0}
 };
 
@@ -549,3 +561,112 @@ static int proc_cmd_getupd(int s, int argc, char **argv)
 	write(s, buf, len);
 	return 0;
 }
+
+static int proc_cmd_power(int s, int argc, char **argv)
+{
+	char buf[128];
+	int len;
+
+	send_status(s, 1);
+	len = sprintf(buf, "2\nstate: %s\nidle: %ld ms\n", power_state_name(power_state()),
+			power_idle_msec());
+	write(s, buf, len);
+	return 0;
+}
+
+static int proc_cmd_stats(int s, int argc, char **argv)
+{
+	int i, len;
+	char *ptr, buf[1024];
+	struct stats_summary sum;
+	double fps = 0.0;
+
+	if(argc > 1) {
+		if(strcmp(argv[1], "reset") != 0) {
+			return -1;
+		}
+		stats_reset();
+		send_status(s, 1);
+		write(s, "0\n", 2);
+		return 0;
+	}
+
+	if(stats_get(STATS_INTERVAL, &sum) != -1 && sum.avg > 0) {
+		fps = 1000000.0 / sum.avg;
+	}
+
+	ptr = buf;
+	ptr += sprintf(ptr, "%d\n", NUM_STATS + 1);
+	ptr += sprintf(ptr, "frames: %lu (dropped: %lu)  fps: %.2f\n", stats_frames(),
+			stats_dropped_frames(), fps);
+	for(i=0; i<NUM_STATS; i++) {
+		if(stats_get(i, &sum) == -1) {
+			ptr += sprintf(ptr, "%s: no data\n", stats_name(i));
+			continue;
+		}
+		ptr += sprintf(ptr, "%s: avg %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f ms\n",
+				stats_name(i), sum.avg / 1000.0, sum.p50 / 1000.0, sum.p95 / 1000.0,
+				sum.p99 / 1000.0, sum.max / 1000.0);
+	}
+	len = ptr - buf;
+
+	send_status(s, 1);
+	write(s, buf, len);
+	return 0;
+}
+
+static int proc_cmd_time(int s, int argc, char **argv)
+{
+	char buf[128];
+	int len;
+
+	if(argc > 1 && timesrc_set(argv[1]) == -1) {
+		return -1;
+	}
+
+	send_status(s, 1);
+	strcpy(buf, "1\n");
+	timesrc_describe(buf + 2, sizeof buf - 3);
+	len = strlen(buf);
+	buf[len++] = '\n';
+	write(s, buf, len);
+	return 0;
+}
+
+static int proc_cmd_capture(int s, int argc, char **argv)
+{
+	char *buf;
+	int len;
+	const char *path;
+	unsigned long written, dropped;
+
+	if(argc > 1) {
+		if(strcmp(argv[1], "start") == 0) {
+			if(argc < 3 || capture_start(argv[2]) == -1) {
+				return -1;
+			}
+		} else if(strcmp(argv[1], "stop") == 0) {
+			if(!capture_path()) {
+				return -1;
+			}
+			capture_stop();
+		} else {
+			return -1;
+		}
+	}
+
+	path = capture_path();
+	buf = alloca((path ? strlen(path) : 0) + 128);
+	capture_status(&written, &dropped);
+	if(path) {
+		len = sprintf(buf, "1\ncapturing to %s: %lu frames (dropped: %lu)\n", path, written, dropped);
+	} else if(argc > 1) {
+		len = sprintf(buf, "1\ncapture stopped: %lu frames (dropped: %lu)\n", written, dropped);
+	} else {
+		len = sprintf(buf, "1\nnot capturing\n");
+	}
+
+	send_status(s, 1);
+	write(s, buf, len);
+	return 0;
+}
@@ -23,7 +23,4 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 int ctrl_init(void);
 void ctrl_shutdown(void);
 
-int *ctrl_sockets(int *count);
-void ctrl_process(int s);
-
 #endif	/* CTRL_H_ */
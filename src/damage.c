@@ -0,0 +1,259 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "opengl.h"
+#include <GL/glx.h>
+#include "damage.h"
+#include "app.h"
+#include "still.h"
+
+#ifndef GLX_BACK_BUFFER_AGE_EXT
+#define GLX_BACK_BUFFER_AGE_EXT	0x20f4
+#endif
+
+/* damaged rectangles tracked per frame, past that they're merged */
+#define MAX_RECTS	16
+/* frames of damage history kept for GLX_EXT_buffer_age */
+#define MAX_AGE		4
+
+struct rect {
+	int x, y, w, h;		/* root window coordinates, y down. w < 0: everything */
+};
+
+typedef void (*glx_copy_sub_buffer_func)(Display*, GLXDrawable, int, int, int, int);
+
+static void add_rect(struct rect *dest, struct rect *r);
+static void set_scissor(void);
+
+static Display *dpy;
+static Window win;
+static int mode = DAMAGE_NONE;
+static glx_copy_sub_buffer_func copy_sub_buffer;
+
+static struct rect cur[MAX_RECTS];
+static int num_cur, reported;
+static int invalid = 1;
+static int full_frame = 1;
+
+/* region missing from the back buffer, which also has to be redrawn */
+static struct rect missing;
+static int back_valid;		/* DAMAGE_COPY_SUB_BUFFER: back buffer is complete */
+
+static struct rect hist[MAX_AGE];
+static int hist_head, hist_len;
+
+static const char *mode_names[] = {"none", "buffer age", "copy sub buffer"};
+
+
+void damage_init(Display *d, Window w)
+{
+	const char *ext;
+
+	dpy = d;
+	win = w;
+	mode = DAMAGE_NONE;
+
+	if(!(ext = glXQueryExtensionsString(dpy, DefaultScreen(dpy)))) {
+		return;
+	}
+
+	if(strstr(ext, "GLX_MESA_copy_sub_buffer")) {
+		void (*func)(void) = glXGetProcAddress((unsigned char*)"glXCopySubBufferMESA");
+		if(func) {
+			memcpy(&copy_sub_buffer, &func, sizeof copy_sub_buffer);
+			mode = DAMAGE_COPY_SUB_BUFFER;
+		}
+	}
+	if(mode == DAMAGE_NONE && strstr(ext, "GLX_EXT_buffer_age")) {
+		mode = DAMAGE_BUFFER_AGE;
+	}
+
+	printf("xlivebg: partial redraw: %s\n", mode_names[mode]);
+	damage_invalidate();
+}
+
+int damage_mode(void)
+{
+	return mode;
+}
+
+const char *damage_mode_name(void)
+{
+	return mode_names[mode];
+}
+
+void damage_invalidate(void)
+{
+	invalid = 1;
+	back_valid = 0;
+	hist_len = 0;
+	/* a static frame has to be drawn again too */
+	still_invalidate();
+}
+
+void damage_frame_begin(void)
+{
+	unsigned int age;
+	int i;
+
+	num_cur = reported = 0;
+	missing.w = missing.h = 0;
+
+	if(invalid || mode == DAMAGE_NONE) {
+		full_frame = 1;
+		return;
+	}
+	full_frame = 0;
+
+	if(mode == DAMAGE_COPY_SUB_BUFFER) {
+		if(!back_valid) {
+			missing.w = -1;
+		}
+	} else {
+		/* the back buffer is age frames old, so it's missing whatever changed
+		 * in the last age-1 frames.
+		 */
+		age = 0;
+		glXQueryDrawable(dpy, win, GLX_BACK_BUFFER_AGE_EXT, &age);
+		if(age == 0 || age - 1 > hist_len) {
+			missing.w = -1;
+		} else {
+			for(i=0; i<age - 1; i++) {
+				add_rect(&missing, hist + (hist_head + MAX_AGE - i) % MAX_AGE);
+			}
+		}
+	}
+}
+
+int damage_partial(void)
+{
+	return mode != DAMAGE_NONE && !full_frame && missing.w == 0;
+}
+
+void damage_add(int x, int y, int w, int h)
+{
+	struct rect r;
+
+	if(full_frame) return;
+	reported = 1;
+
+	/* clip to the root window */
+	if(x < 0) {
+		w += x;
+		x = 0;
+	}
+	if(y < 0) {
+		h += y;
+		y = 0;
+	}
+	if(x + w > scr_width) w = scr_width - x;
+	if(y + h > scr_height) h = scr_height - y;
+	if(w <= 0 || h <= 0) {
+		set_scissor();
+		return;
+	}
+
+	r.x = x;
+	r.y = y;
+	r.w = w;
+	r.h = h;
+	if(num_cur < MAX_RECTS) {
+		cur[num_cur++] = r;
+	} else {
+		add_rect(cur + MAX_RECTS - 1, &r);
+	}
+	set_scissor();
+}
+
+void damage_present(void)
+{
+	int i;
+	struct rect bbox;
+
+	if(full_frame || !reported) {
+		glXSwapBuffers(dpy, win);
+		back_valid = 0;
+		bbox.w = -1;
+	} else {
+		if(!num_cur) {
+			/* nothing changed, nothing to present */
+			if(mode == DAMAGE_COPY_SUB_BUFFER) back_valid = 1;
+			glDisable(GL_SCISSOR_TEST);
+			invalid = 0;
+			return;
+		}
+
+		bbox.w = bbox.h = 0;
+		for(i=0; i<num_cur; i++) {
+			add_rect(&bbox, cur + i);
+		}
+
+		if(mode == DAMAGE_COPY_SUB_BUFFER) {
+			for(i=0; i<num_cur; i++) {
+				copy_sub_buffer(dpy, win, cur[i].x, scr_height - cur[i].y - cur[i].h,
+						cur[i].w, cur[i].h);
+			}
+			back_valid = 1;
+		} else {
+			glXSwapBuffers(dpy, win);
+		}
+	}
+	glDisable(GL_SCISSOR_TEST);
+	invalid = 0;
+
+	hist_head = (hist_head + 1) % MAX_AGE;
+	hist[hist_head] = bbox;
+	if(hist_len < MAX_AGE) hist_len++;
+}
+
+/* grows dest to include r. Empty rectangles have zero w or h */
+static void add_rect(struct rect *dest, struct rect *r)
+{
+	int x1, y1;
+
+	if(dest->w < 0 || r->w == 0 || r->h == 0) return;
+	if(r->w < 0 || dest->w == 0 || dest->h == 0) {
+		*dest = *r;
+		return;
+	}
+
+	x1 = dest->x + dest->w > r->x + r->w ? dest->x + dest->w : r->x + r->w;
+	y1 = dest->y + dest->h > r->y + r->h ? dest->y + dest->h : r->y + r->h;
+	if(r->x < dest->x) dest->x = r->x;
+	if(r->y < dest->y) dest->y = r->y;
+	dest->w = x1 - dest->x;
+	dest->h = y1 - dest->y;
+}
+
+/* restricts drawing to the current damage, plus whatever the back buffer is
+ * missing. GL window coordinates have y up.
+ */
+static void set_scissor(void)
+{
+	int i;
+	struct rect bbox = missing;
+
+	if(bbox.w < 0) return;
+
+	for(i=0; i<num_cur; i++) {
+		add_rect(&bbox, cur + i);
+	}
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(bbox.x, scr_height - bbox.y - bbox.h, bbox.w, bbox.h);
+}
@@ -0,0 +1,59 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef DAMAGE_H_
+#define DAMAGE_H_
+
+#include <X11/Xlib.h>
+
+/* Damage tracking: when the active plugin reports which parts of the screen it
+ * changed, only those are redrawn (scissored) and presented. Uses
+ * GLX_MESA_copy_sub_buffer to present just the damaged rectangles, or failing
+ * that GLX_EXT_buffer_age to limit redrawing to what's missing from the back
+ * buffer. Frames without any reported damage are full redraws and swaps.
+ */
+enum {
+	DAMAGE_NONE,			/* always full redraws and swaps */
+	DAMAGE_BUFFER_AGE,		/* scissored redraws, full swaps */
+	DAMAGE_COPY_SUB_BUFFER	/* scissored redraws, partial presents */
+};
+
+/* detects the available GLX extensions, must be called with the window context current */
+void damage_init(Display *dpy, Window win);
+int damage_mode(void);
+const char *damage_mode_name(void);
+
+/* forces the next frame to be redrawn and presented in full. Called when
+ * the window contents are lost, or change entirely (plugin switch, resize...)
+ */
+void damage_invalidate(void);
+
+/* called before and after the plugin draws each frame. damage_present swaps
+ * buffers, or copies only the damaged regions to the front buffer.
+ */
+void damage_frame_begin(void);
+void damage_present(void);
+
+/* returns non-zero if the back buffer holds the complete previous frame, so
+ * that parts of the screen may be left undrawn this frame.
+ */
+int damage_partial(void);
+
+/* adds a damaged rectangle for the current frame, in root window coordinates */
+void damage_add(int x, int y, int w, int h);
+
+#endif	/* DAMAGE_H_ */
@@ -0,0 +1,291 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#else
+#include <sys/select.h>
+#endif
+#ifdef HAVE_TIMERFD
+#include <sys/timerfd.h>
+#endif
+#include "evloop.h"
+#include "sched.h"
+
+struct watcher {
+	int fd;
+	evloop_func func;
+	void *cls;
+	struct watcher *next;
+};
+
+static struct watcher *wlist;
+/* watchers removed while dispatching, are freed after the dispatch is done */
+static struct watcher *dead;
+
+#ifdef HAVE_EPOLL
+#define MAX_EVENTS	16
+static int epfd = -1;
+#endif
+#ifdef HAVE_TIMERFD
+static int tmfd = -1;
+static int64_t tm_armed = -1;
+static struct watcher tm_watcher;
+#endif
+
+static void free_dead(void);
+
+int evloop_init(void)
+{
+#ifdef HAVE_EPOLL
+	if(epfd >= 0) {
+		fprintf(stderr, "evloop_init: already initialized!\n");
+		return -1;
+	}
+	if((epfd = epoll_create(MAX_EVENTS)) == -1) {
+		fprintf(stderr, "evloop_init: failed to create epoll instance: %s\n", strerror(errno));
+		return -1;
+	}
+#ifdef HAVE_TIMERFD
+	/* frame deadlines are absolute times on the monotonic clock, which is
+	 * exactly what an absolute timerfd on CLOCK_MONOTONIC expects.
+	 */
+	if((tmfd = timerfd_create(CLOCK_MONOTONIC, 0)) != -1) {
+		struct epoll_event ev = {0};
+
+		tm_watcher.fd = tmfd;
+		ev.events = EPOLLIN;
+		ev.data.ptr = &tm_watcher;
+		if(epoll_ctl(epfd, EPOLL_CTL_ADD, tmfd, &ev) == -1) {
+			close(tmfd);
+			tmfd = -1;
+		}
+	}
+	if(tmfd == -1) {
+		fprintf(stderr, "evloop_init: failed to create frame timer, falling back to epoll timeouts\n");
+	}
+#endif
+#endif	/* HAVE_EPOLL */
+	return 0;
+}
+
+void evloop_shutdown(void)
+{
+	struct watcher *w;
+
+	while(wlist) {
+		w = wlist;
+		wlist = wlist->next;
+		free(w);
+	}
+	free_dead();
+
+#ifdef HAVE_TIMERFD
+	if(tmfd >= 0) {
+		close(tmfd);
+		tmfd = -1;
+		tm_armed = -1;
+	}
+#endif
+#ifdef HAVE_EPOLL
+	if(epfd >= 0) {
+		close(epfd);
+		epfd = -1;
+	}
+#endif
+}
+
+/* in a forked child which doesn't run the event loop: closes every watched file
+ * descriptor (connections, listening sockets, inotify), the frame timer and the
+ * epoll instance, all of which belong to the parent.
+ */
+void evloop_after_fork(void)
+{
+	struct watcher *w;
+
+	for(w=wlist; w; w=w->next) {
+		close(w->fd);
+	}
+	evloop_shutdown();
+}
+
+int evloop_add(int fd, evloop_func func, void *cls)
+{
+	struct watcher *w;
+#ifdef HAVE_EPOLL
+	struct epoll_event ev = {0};
+#endif
+
+	if(!(w = malloc(sizeof *w))) {
+		perror("evloop_add: failed to allocate watcher");
+		return -1;
+	}
+	w->fd = fd;
+	w->func = func;
+	w->cls = cls;
+
+#ifdef HAVE_EPOLL
+	ev.events = EPOLLIN;
+	ev.data.ptr = w;
+	if(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+		fprintf(stderr, "evloop_add: failed to add fd %d: %s\n", fd, strerror(errno));
+		free(w);
+		return -1;
+	}
+#endif
+
+	w->next = wlist;
+	wlist = w;
+	return 0;
+}
+
+void evloop_remove(int fd)
+{
+	struct watcher dummy, *prev, *w;
+
+	dummy.next = wlist;
+	prev = &dummy;
+	while(prev->next) {
+		w = prev->next;
+		if(w->fd == fd) {
+#ifdef HAVE_EPOLL
+			epoll_ctl(epfd, EPOLL_CTL_DEL, fd, 0);
+#endif
+			prev->next = w->next;
+			/* don't free it yet, there might be pending events referencing it */
+			w->fd = -1;
+			w->next = dead;
+			dead = w;
+			break;
+		}
+		prev = w;
+	}
+	wlist = dummy.next;
+}
+
+static void free_dead(void)
+{
+	struct watcher *w;
+
+	while(dead) {
+		w = dead;
+		dead = dead->next;
+		free(w);
+	}
+}
+
+#ifdef HAVE_EPOLL
+int evloop_wait(int64_t deadline)
+{
+	int i, nev, timeout = -1;
+	struct watcher *w;
+	struct epoll_event ev[MAX_EVENTS];
+
+#ifdef HAVE_TIMERFD
+	if(tmfd >= 0) {
+		if(deadline != tm_armed) {
+			struct itimerspec its = {{0}};
+
+			/* all zeroes disarms the timer, so make sure a deadline at 0 still fires */
+			if(deadline >= 0) {
+				its.it_value.tv_sec = deadline / 1000000;
+				its.it_value.tv_nsec = (deadline % 1000000) * 1000;
+				if(!its.it_value.tv_sec && !its.it_value.tv_nsec) {
+					its.it_value.tv_nsec = 1;
+				}
+			}
+			timerfd_settime(tmfd, TFD_TIMER_ABSTIME, &its, 0);
+			tm_armed = deadline;
+		}
+	} else
+#endif
+	if(deadline >= 0) {
+		int64_t usec = deadline - sched_time_usec();
+		timeout = usec > 0 ? (usec + 999) / 1000 : 0;
+	}
+
+	if((nev = epoll_wait(epfd, ev, MAX_EVENTS, timeout)) == -1) {
+		return -1;
+	}
+
+	for(i=0; i<nev; i++) {
+		w = ev[i].data.ptr;
+#ifdef HAVE_TIMERFD
+		if(w == &tm_watcher) {
+			uint64_t nexp;
+			read(tmfd, &nexp, sizeof nexp);
+			tm_armed = -1;
+			continue;
+		}
+#endif
+		if(w->fd >= 0 && w->func) {
+			w->func(w->fd, w->cls);
+		}
+	}
+
+	free_dead();
+	return nev;
+}
+
+#else	/* !HAVE_EPOLL */
+int evloop_wait(int64_t deadline)
+{
+	int res, max_fd = -1, count = 0;
+	fd_set rdset;
+	struct timeval tv, *timeout = 0;
+	struct watcher *w;
+
+	FD_ZERO(&rdset);
+	for(w=wlist; w; w=w->next) {
+		FD_SET(w->fd, &rdset);
+		if(w->fd > max_fd) max_fd = w->fd;
+	}
+
+	if(deadline >= 0) {
+		int64_t usec = deadline - sched_time_usec();
+		if(usec < 0) usec = 0;
+		tv.tv_sec = usec / 1000000;
+		tv.tv_usec = usec % 1000000;
+		timeout = &tv;
+	}
+
+	if((res = select(max_fd + 1, &rdset, 0, 0, timeout)) <= 0) {
+		return res;
+	}
+
+	/* callbacks may add or remove watchers, so start over after each one */
+restart:
+	for(w=wlist; w; w=w->next) {
+		if(FD_ISSET(w->fd, &rdset)) {
+			FD_CLR(w->fd, &rdset);
+			count++;
+			if(w->func) {
+				w->func(w->fd, w->cls);
+				goto restart;
+			}
+		}
+	}
+
+	free_dead();
+	return count;
+}
+#endif	/* HAVE_EPOLL */
@@ -0,0 +1,44 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef EVLOOP_H_
+#define EVLOOP_H_
+
+#include <inttypes.h>
+
+typedef void (*evloop_func)(int fd, void *cls);
+
+int evloop_init(void);
+void evloop_shutdown(void);
+/* closes all file descriptors of the event loop, in a forked child */
+void evloop_after_fork(void);
+
+/* registers a file descriptor to be watched for input. func is called with
+ * the file descriptor and cls, whenever there's something to read. func may
+ * be null, in which case input on fd just wakes up the event loop.
+ */
+int evloop_add(int fd, evloop_func func, void *cls);
+void evloop_remove(int fd);
+
+/* waits for events, and dispatches them to their callbacks. Returns when at
+ * least one event was handled, or when the absolute deadline (in the time base
+ * of sched_time_usec) is reached. Pass a negative deadline to wait forever.
+ * Returns the number of events handled, or -1 on error (or signal).
+ */
+int evloop_wait(int64_t deadline);
+
+#endif	/* EVLOOP_H_ */
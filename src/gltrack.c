@@ -0,0 +1,280 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#define _GNU_SOURCE
+#define GL_GLEXT_PROTOTYPES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GL/glx.h>
+#include "gltrack.h"
+
+enum {
+	OBJ_TEXTURE,
+	OBJ_BUFFER,
+	OBJ_FRAMEBUFFER,
+	OBJ_RENDERBUFFER,
+	OBJ_VERTEX_ARRAY,
+	OBJ_PROGRAM,
+	OBJ_SHADER,
+
+	NUM_OBJ_TYPES
+};
+
+struct globj {
+	int type;
+	unsigned int name;
+	void *owner;
+};
+
+typedef void (*glfunc)(void);
+typedef void (*genfunc)(GLsizei, GLuint*);
+typedef void (*delfunc)(GLsizei, const GLuint*);
+typedef GLuint (*createfunc)(void);
+typedef GLuint (*createshaderfunc)(GLenum);
+typedef void (*delonefunc)(GLuint);
+
+static void track(int type, int count, const unsigned int *names);
+static void untrack(int type, int count, const unsigned int *names);
+static glfunc real_func(glfunc *fptr, const char *name);
+
+static struct globj *objs;
+static int num_objs, max_objs;
+static void *cur_owner;
+
+/* pointers to the real GL functions, resolved on first use */
+static glfunc real_gen[NUM_OBJ_TYPES], real_del[NUM_OBJ_TYPES];
+static glfunc real_create_program, real_create_shader;
+
+static const char *gen_names[] = {
+	"glGenTextures", "glGenBuffers", "glGenFramebuffers", "glGenRenderbuffers",
+	"glGenVertexArrays", 0, 0
+};
+static const char *del_names[] = {
+	"glDeleteTextures", "glDeleteBuffers", "glDeleteFramebuffers", "glDeleteRenderbuffers",
+	"glDeleteVertexArrays", "glDeleteProgram", "glDeleteShader"
+};
+
+
+void *gltrack_owner(void *owner)
+{
+	void *prev = cur_owner;
+	cur_owner = owner;
+	return prev;
+}
+
+int gltrack_release(void *owner)
+{
+	int i, count = 0;
+	struct globj *obj;
+
+	if(!owner) return 0;
+
+	i = 0;
+	while(i < num_objs) {
+		obj = objs + i;
+		if(obj->owner != owner) {
+			i++;
+			continue;
+		}
+
+		if(obj->type == OBJ_PROGRAM || obj->type == OBJ_SHADER) {
+			delonefunc del = (delonefunc)real_func(real_del + obj->type, del_names[obj->type]);
+			if(del) del(obj->name);
+		} else {
+			delfunc del = (delfunc)real_func(real_del + obj->type, del_names[obj->type]);
+			if(del) del(1, &obj->name);
+		}
+		count++;
+
+		/* order doesn't matter, move the last one in its place */
+		objs[i] = objs[--num_objs];
+	}
+	return count;
+}
+
+static void gen_objects(int type, GLsizei n, GLuint *names)
+{
+	genfunc gen = (genfunc)real_func(real_gen + type, gen_names[type]);
+	if(gen) {
+		gen(n, names);
+		track(type, n, names);
+	}
+}
+
+static void delete_objects(int type, GLsizei n, const GLuint *names)
+{
+	delfunc del = (delfunc)real_func(real_del + type, del_names[type]);
+	if(del) {
+		untrack(type, n, names);
+		del(n, names);
+	}
+}
+
+static void delete_object(int type, GLuint name)
+{
+	delonefunc del = (delonefunc)real_func(real_del + type, del_names[type]);
+	if(del) {
+		untrack(type, 1, &name);
+		del(name);
+	}
+}
+
+/* interposed GL functions */
+void glGenTextures(GLsizei n, GLuint *tex)
+{
+	gen_objects(OBJ_TEXTURE, n, tex);
+}
+
+void glDeleteTextures(GLsizei n, const GLuint *tex)
+{
+	delete_objects(OBJ_TEXTURE, n, tex);
+}
+
+void glGenBuffers(GLsizei n, GLuint *buf)
+{
+	gen_objects(OBJ_BUFFER, n, buf);
+}
+
+void glDeleteBuffers(GLsizei n, const GLuint *buf)
+{
+	delete_objects(OBJ_BUFFER, n, buf);
+}
+
+void glGenFramebuffers(GLsizei n, GLuint *fb)
+{
+	gen_objects(OBJ_FRAMEBUFFER, n, fb);
+}
+
+void glDeleteFramebuffers(GLsizei n, const GLuint *fb)
+{
+	delete_objects(OBJ_FRAMEBUFFER, n, fb);
+}
+
+void glGenRenderbuffers(GLsizei n, GLuint *rb)
+{
+	gen_objects(OBJ_RENDERBUFFER, n, rb);
+}
+
+void glDeleteRenderbuffers(GLsizei n, const GLuint *rb)
+{
+	delete_objects(OBJ_RENDERBUFFER, n, rb);
+}
+
+void glGenVertexArrays(GLsizei n, GLuint *va)
+{
+	gen_objects(OBJ_VERTEX_ARRAY, n, va);
+}
+
+void glDeleteVertexArrays(GLsizei n, const GLuint *va)
+{
+	delete_objects(OBJ_VERTEX_ARRAY, n, va);
+}
+
+GLuint glCreateProgram(void)
+{
+	GLuint prog = 0;
+	createfunc create = (createfunc)real_func(&real_create_program, "glCreateProgram");
+
+	if(create && (prog = create())) {
+		track(OBJ_PROGRAM, 1, &prog);
+	}
+	return prog;
+}
+
+void glDeleteProgram(GLuint prog)
+{
+	delete_object(OBJ_PROGRAM, prog);
+}
+
+GLuint glCreateShader(GLenum type)
+{
+	GLuint sdr = 0;
+	createshaderfunc create = (createshaderfunc)real_func(&real_create_shader, "glCreateShader");
+
+	if(create && (sdr = create(type))) {
+		track(OBJ_SHADER, 1, &sdr);
+	}
+	return sdr;
+}
+
+void glDeleteShader(GLuint sdr)
+{
+	delete_object(OBJ_SHADER, sdr);
+}
+
+
+static void track(int type, int count, const unsigned int *names)
+{
+	int i;
+
+	if(!cur_owner) return;	/* core objects are not tracked */
+
+	for(i=0; i<count; i++) {
+		if(!names[i]) continue;
+
+		if(num_objs >= max_objs) {
+			int nmax = max_objs ? max_objs * 2 : 64;
+			struct globj *tmp = realloc(objs, nmax * sizeof *objs);
+			if(!tmp) {
+				perror("gltrack: failed to resize object list");
+				return;
+			}
+			objs = tmp;
+			max_objs = nmax;
+		}
+		objs[num_objs].type = type;
+		objs[num_objs].name = names[i];
+		objs[num_objs].owner = cur_owner;
+		num_objs++;
+	}
+}
+
+static void untrack(int type, int count, const unsigned int *names)
+{
+	int i, j;
+
+	for(i=0; i<count; i++) {
+		for(j=0; j<num_objs; j++) {
+			if(objs[j].type == type && objs[j].name == names[i]) {
+				objs[j] = objs[--num_objs];
+				break;
+			}
+		}
+	}
+}
+
+/* looks up the real GL function, which comes after us in the symbol
+ * resolution order, and caches it in *fptr
+ */
+static glfunc real_func(glfunc *fptr, const char *name)
+{
+	void *sym;
+
+	if(!*fptr) {
+		if((sym = dlsym(RTLD_NEXT, name))) {
+			/* ISO C doesn't allow casting object pointers to function pointers */
+			memcpy(fptr, &sym, sizeof *fptr);
+		} else if(!(*fptr = glXGetProcAddress((unsigned char*)name))) {
+			fprintf(stderr, "gltrack: failed to find %s\n", name);
+		}
+	}
+	return *fptr;
+}
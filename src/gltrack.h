@@ -0,0 +1,38 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef GLTRACK_H_
+#define GLTRACK_H_
+
+/* GL object tracking. The OpenGL context is kept alive across plugin
+ * switches, so the core keeps track of the GL objects created while each
+ * plugin is active, and frees whatever the plugin left behind when it's
+ * stopped. Tracking works by interposing the most common object creation and
+ * deletion functions (glGenTextures, glCreateProgram, etc) which the plugins
+ * link to; objects created through function pointers acquired with
+ * glXGetProcAddress are not tracked.
+ */
+
+/* sets the owner of subsequently created GL objects, and returns the
+ * previous owner. Owner 0 is the core itself, which is never released.
+ */
+void *gltrack_owner(void *owner);
+
+/* deletes all GL objects still owned by owner, returns how many were freed */
+int gltrack_release(void *owner);
+
+#endif	/* GLTRACK_H_ */
@@ -0,0 +1,784 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#ifdef HAVE_ALLOCA_H
+#include <alloca.h>
+#endif
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+#include "opengl.h"
+#include "host.h"
+#include "app.h"
+#include "cfg.h"
+#include "quality.h"
+#include "sched.h"
+#include "evloop.h"
+#include "swrender.h"
+#include "imageman.h"
+#include "layer.h"
+#include "bgcache.h"
+#include "rscale.h"
+#include "loopcache.h"
+#include "still.h"
+#include "plugin.h"
+#include "gltrack.h"
+
+/* milliseconds to wait for the host to initialize and start the plugin */
+#define START_TIMEOUT	10000
+/* minimum time between attempts to restart a failed host, in microseconds */
+#define RESTART_DELAY	1000000
+
+enum {
+	HOST_DRAW,
+	HOST_CFG,
+	HOST_QUIT
+};
+
+struct request {
+	int cmd;
+	int size;			/* size of the message following the request, if any */
+	int width, height;
+	int buf;			/* shared frame buffer to read an OpenGL frame into */
+	int quality;
+	int mouse_x, mouse_y;
+	unsigned long msec;
+	int64_t frame_time;
+	long frame_delta;
+	unsigned long frame_count;
+	/* screens to draw, which change as outputs are covered or rescaled */
+	int num_vis;
+	int vis[MAX_SCR];
+	int vport[MAX_SCR][4];
+};
+
+/* follows a HOST_CFG request, with the option path and its string value right
+ * after it, both null-terminated.
+ */
+struct cfg_msg {
+	int type;			/* TS_* value type, or -1 if the option was removed */
+	int inum;
+	float fnum;
+	int vec_size;
+	float vec[4];
+};
+
+/* sent back after starting the plugin, and after every request. Carries the
+ * state the plugin sets through the API, which only changes in the host.
+ */
+struct reply {
+	int status;
+	long upd_interval;
+	int still;			/* output declared static */
+	long period;		/* animation period, see xlivebg_set_period */
+};
+
+static int spawn(void);
+static void kill_host(void);
+static int draw_request(int width, int height);
+static int send_request(struct request *req, void *data, int timeout);
+static int wait_reply(int timeout);
+static int read_reply(void);
+static int collect_frame(int wait);
+static int alloc_frame(int width, int height);
+static void free_frame(void);
+static void draw_frame(int width, int height);
+static void host_main(void);
+static int host_init_gl(void);
+static int send_reply(int status);
+static int recv_cfg(int size);
+
+static struct xlivebg_plugin *plugin;	/* hosted plugin, null if none */
+static pid_t pid;
+static int sock = -1;
+static uint32_t *host_fb;				/* framebuffer the host was forked with */
+static int host_width, host_height;
+static int64_t restart_time;			/* earliest time to restart a failed host */
+
+/* OpenGL hosts draw on a pbuffer of their own, and read each frame back into
+ * one of these shared buffers, which is then uploaded to frame_tex and drawn
+ * here. xlivebg doesn't wait for the host: it asks for the next frame to be
+ * drawn in the other buffer, and keeps showing the last complete one.
+ */
+static uint32_t *gl_frame[2];
+static long gl_frame_size;				/* size of each buffer */
+static int draw_buf = -1;				/* buffer being drawn, -1 if none */
+static int front = -1;					/* last complete frame */
+static int front_new;					/* ... which isn't uploaded yet */
+static int64_t req_time;				/* time draw_buf was requested */
+static unsigned int frame_tex;
+static int tex_width, tex_height;
+
+/* host process state */
+static int in_host;
+static int mouse_x, mouse_y;
+
+
+int host_start(struct xlivebg_plugin *p)
+{
+	host_stop();
+	plugin = p;
+	restart_time = 0;
+	return spawn();
+}
+
+void host_stop(void)
+{
+	struct request req;
+
+	if(!plugin) return;
+
+	/* the reply for a frame still being drawn comes before the one to quit */
+	if(pid > 0) {
+		collect_frame(1);
+	}
+	if(pid > 0) {
+		memset(&req, 0, sizeof req);
+		req.cmd = HOST_QUIT;
+		if(send_request(&req, 0, cfg.isolate_timeout) == -1) {
+			kill_host();
+		} else {
+			waitpid(pid, 0, 0);
+			pid = 0;
+			close(sock);
+			sock = -1;
+		}
+	}
+	free_frame();
+	/* don't show the last frame of this plugin when the next one starts */
+	tex_width = tex_height = 0;
+	plugin = 0;
+}
+
+void host_restart(void)
+{
+	struct xlivebg_plugin *p = plugin;
+
+	if(!p) return;
+
+	printf("host: restarting %s\n", p->name);
+	host_stop();
+	plugin = p;
+	if(spawn() == -1) {
+		restart_time = sched_time_usec() + RESTART_DELAY;
+	}
+}
+
+void host_setcfg(const char *cfgpath, struct ts_value *tsval)
+{
+	struct request req;
+	struct cfg_msg *msg;
+	const char *str;
+	char *ptr;
+	int size;
+
+	/* a host which is being restarted gets a fresh copy anyway */
+	if(!plugin || pid <= 0) return;
+	if(collect_frame(1) == -1) return;
+
+	str = tsval && tsval->str ? tsval->str : "";
+	size = sizeof *msg + strlen(cfgpath) + strlen(str) + 2;
+	msg = alloca(size);
+	memset(msg, 0, sizeof *msg);
+
+	if(tsval) {
+		msg->type = tsval->type;
+		msg->inum = tsval->inum;
+		msg->fnum = tsval->fnum;
+		if(tsval->vec) {
+			msg->vec_size = tsval->vec_size > 4 ? 4 : tsval->vec_size;
+			memcpy(msg->vec, tsval->vec, msg->vec_size * sizeof *msg->vec);
+		}
+	} else {
+		msg->type = -1;
+	}
+	ptr = (char*)(msg + 1);
+	strcpy(ptr, cfgpath);
+	strcpy(ptr + strlen(cfgpath) + 1, str);
+
+	memset(&req, 0, sizeof req);
+	req.cmd = HOST_CFG;
+	req.size = size;
+	if(send_request(&req, msg, cfg.isolate_timeout) == -1) {
+		kill_host();
+		restart_time = sched_time_usec() + RESTART_DELAY;
+	}
+}
+
+int host_active(void)
+{
+	return !in_host && plugin;
+}
+
+void host_draw(uint32_t *pixels, int stride, int width, int height)
+{
+	if(!plugin) return;
+
+	/* the host draws straight into the framebuffer it inherited, which is
+	 * replaced when the window is resized.
+	 */
+	if(pid > 0 && (pixels != host_fb || width != host_width || height != host_height)) {
+		host_restart();
+	}
+	draw_request(width, height);
+}
+
+void host_draw_gl(int width, int height, int wait)
+{
+	if(!plugin) return;
+
+	/* the pbuffer of the host is created at the size of the framebuffer */
+	if(pid > 0 && (width != host_width || height != host_height)) {
+		host_restart();
+	}
+
+	if(collect_frame(wait) != -1 && draw_buf == -1) {
+		draw_request(width, height);
+		if(wait) {
+			collect_frame(1);
+		}
+	}
+	draw_frame(width, height);
+}
+
+void host_destroy_gl(void)
+{
+	if(frame_tex) {
+		glDeleteTextures(1, &frame_tex);
+		frame_tex = 0;
+	}
+}
+
+int host_mouse(int *x, int *y)
+{
+	if(!in_host) return 0;
+
+	*x = mouse_x;
+	*y = mouse_y;
+	return 1;
+}
+
+static int spawn(void)
+{
+	int sv[2], stride;
+
+	if(sw_render) {
+		host_fb = swr_framebuffer(&stride);
+		host_width = scr_width;
+		host_height = scr_height;
+	} else {
+		host_width = rscale_width();
+		host_height = rscale_height();
+		if(alloc_frame(host_width, host_height) == -1) {
+			return -1;
+		}
+	}
+
+	if(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) == -1) {
+		fprintf(stderr, "host: failed to create socket pair: %s\n", strerror(errno));
+		return -1;
+	}
+
+	/* don't let the child inherit anything still buffered, or a current
+	 * OpenGL context. It opens its own.
+	 */
+	fflush(stdout);
+	fflush(stderr);
+	if(!sw_render) {
+		glFinish();
+		xlivebg_bind_gl(0);
+	}
+
+	if((pid = fork()) == -1) {
+		fprintf(stderr, "host: failed to fork: %s\n", strerror(errno));
+		xlivebg_bind_gl(1);
+		close(sv[0]);
+		close(sv[1]);
+		pid = 0;
+		return -1;
+	}
+	if(!pid) {
+		close(sv[0]);
+		sock = sv[1];
+		host_main();
+	}
+	xlivebg_bind_gl(1);
+	close(sv[1]);
+	sock = sv[0];
+
+	if(wait_reply(START_TIMEOUT) == -1) {
+		fprintf(stderr, "host: %s failed to start\n", plugin->name);
+		kill_host();
+		return -1;
+	}
+	printf("host: %s running in process %d\n", plugin->name, (int)pid);
+	return 0;
+}
+
+static void kill_host(void)
+{
+	int status;
+
+	if(pid > 0) {
+		kill(pid, SIGKILL);
+		if(waitpid(pid, &status, 0) == pid && WIFSIGNALED(status) && WTERMSIG(status) != SIGKILL) {
+			fprintf(stderr, "host: %s host process terminated by signal %d\n", plugin->name,
+					WTERMSIG(status));
+		}
+		pid = 0;
+	}
+	if(sock >= 0) {
+		close(sock);
+		sock = -1;
+	}
+	/* a frame left half-drawn is of no use */
+	draw_buf = -1;
+	front_new = 0;
+}
+
+/* asks the host to draw a frame, restarting it first if it failed earlier.
+ * Software frames are waited for, OpenGL frames are picked up later by
+ * collect_frame. Returns -1 if there's no new frame on the way.
+ */
+static int draw_request(int width, int height)
+{
+	struct request req;
+	int i;
+
+	if(pid <= 0) {
+		if(sched_time_usec() < restart_time) {
+			return -1;
+		}
+		printf("host: restarting %s\n", plugin->name);
+		if(spawn() == -1) {
+			restart_time = sched_time_usec() + RESTART_DELAY;
+			return -1;
+		}
+	}
+
+	req.cmd = HOST_DRAW;
+	req.width = width;
+	req.height = height;
+	req.quality = quality_level();
+	app_getmouse(&req.mouse_x, &req.mouse_y);
+	req.msec = msec;
+	req.frame_time = frame_time_usec;
+	req.frame_delta = frame_delta_usec;
+	req.frame_count = frame_count;
+
+	req.num_vis = num_vis_screens;
+	memcpy(req.vis, vis_screen, sizeof req.vis);
+	for(i=0; i<num_screens; i++) {
+		memcpy(req.vport[i], screen[i].vport, sizeof req.vport[i]);
+	}
+
+	if(sw_render) {
+		if(send_request(&req, 0, cfg.isolate_timeout) == -1) {
+			kill_host();
+			restart_time = sched_time_usec() + RESTART_DELAY;
+			return -1;
+		}
+		return 0;
+	}
+
+	req.buf = front == 0 ? 1 : 0;
+	if(write(sock, &req, sizeof req) != sizeof req) {
+		fprintf(stderr, "host: %s host process died\n", plugin->name);
+		kill_host();
+		restart_time = sched_time_usec() + RESTART_DELAY;
+		return -1;
+	}
+	draw_buf = req.buf;
+	req_time = sched_time_usec();
+	return 0;
+}
+
+/* data is req->size bytes sent right after the request, if it's not null */
+static int send_request(struct request *req, void *data, int timeout)
+{
+	if(write(sock, req, sizeof *req) != sizeof *req ||
+			(data && write(sock, data, req->size) != req->size)) {
+		fprintf(stderr, "host: %s host process died\n", plugin->name);
+		return -1;
+	}
+	return wait_reply(timeout);
+}
+
+static int wait_reply(int timeout)
+{
+	struct pollfd pfd;
+	int res;
+
+	pfd.fd = sock;
+	pfd.events = POLLIN;
+	while((res = poll(&pfd, 1, timeout > 0 ? timeout : -1)) == -1 && errno == EINTR);
+
+	if(res == 0) {
+		fprintf(stderr, "host: %s not responding after %d ms\n", plugin->name, timeout);
+		return -1;
+	}
+	if(res == -1) {
+		fprintf(stderr, "host: %s host process died\n", plugin->name);
+		return -1;
+	}
+	return read_reply();
+}
+
+static int read_reply(void)
+{
+	struct reply rep;
+
+	if(read(sock, &rep, sizeof rep) != sizeof rep) {
+		fprintf(stderr, "host: %s host process died\n", plugin->name);
+		return -1;
+	}
+
+	if(rep.status != -1) {
+		plugin->upd_interval = rep.upd_interval;
+		still_set_static(rep.still);
+		loopcache_set_period(rep.period);
+	}
+	return rep.status;
+}
+
+/* picks up the frame the host is drawing, if it's done. With wait set, waits
+ * for it instead. Either way the host is killed if it's been more than
+ * isolate.timeout milliseconds since the frame was requested. Returns -1 if
+ * the host failed.
+ */
+static int collect_frame(int wait)
+{
+	struct pollfd pfd;
+	int res, timeout = -1;
+	int64_t elapsed;
+
+	if(draw_buf == -1) return 0;
+
+	if(cfg.isolate_timeout > 0) {
+		elapsed = (sched_time_usec() - req_time) / 1000;
+		timeout = elapsed < cfg.isolate_timeout ? cfg.isolate_timeout - elapsed : 0;
+	}
+
+	pfd.fd = sock;
+	pfd.events = POLLIN;
+	while((res = poll(&pfd, 1, wait ? timeout : 0)) == -1 && errno == EINTR);
+
+	if(res == 0) {
+		if(!wait && timeout != 0) {
+			return 0;	/* still drawing */
+		}
+		fprintf(stderr, "host: %s not responding after %d ms\n", plugin->name, cfg.isolate_timeout);
+		res = -1;
+	} else if(res == -1) {
+		fprintf(stderr, "host: %s host process died\n", plugin->name);
+	} else {
+		res = read_reply();
+	}
+
+	if(res == -1) {
+		kill_host();
+		restart_time = sched_time_usec() + RESTART_DELAY;
+		return -1;
+	}
+	front = draw_buf;
+	front_new = 1;
+	draw_buf = -1;
+	return 0;
+}
+
+static int alloc_frame(int width, int height)
+{
+	long size = (long)width * height * sizeof *gl_frame[0];
+
+	if(gl_frame[0] && size == gl_frame_size) {
+		return 0;
+	}
+	free_frame();
+
+	gl_frame[0] = mmap(0, size * 2, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(gl_frame[0] == MAP_FAILED) {
+		fprintf(stderr, "host: failed to allocate %dx%d shared frames: %s\n", width, height,
+				strerror(errno));
+		gl_frame[0] = 0;
+		return -1;
+	}
+	gl_frame[1] = gl_frame[0] + (long)width * height;
+	gl_frame_size = size;
+	return 0;
+}
+
+static void free_frame(void)
+{
+	if(gl_frame[0]) {
+		munmap(gl_frame[0], gl_frame_size * 2);
+		gl_frame[0] = gl_frame[1] = 0;
+		gl_frame_size = 0;
+	}
+	front = -1;
+	front_new = 0;
+}
+
+/* uploads the frame the host finished last, if it's new, and draws it over
+ * the current framebuffer.
+ */
+static void draw_frame(int width, int height)
+{
+	unsigned int fbo = xlivebg_framebuffer();
+	void *owner;
+
+	gl_reset_state(width, height);
+	if(fbo) {
+		xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, fbo);
+	}
+
+	if(front_new && gl_frame[0]) {
+		if(!frame_tex) {
+			/* the frame belongs to the core, not the hosted plugin */
+			owner = gltrack_owner(0);
+			glGenTextures(1, &frame_tex);
+			gltrack_owner(owner);
+		}
+		glBindTexture(GL_TEXTURE_2D, frame_tex);
+		if(tex_width != width || tex_height != height) {
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_BGRA,
+					GL_UNSIGNED_BYTE, gl_frame[front]);
+			tex_width = width;
+			tex_height = height;
+		} else {
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_BGRA,
+					GL_UNSIGNED_BYTE, gl_frame[front]);
+		}
+		front_new = 0;
+	}
+
+	if(!frame_tex || tex_width != width || tex_height != height) {
+		/* nothing to show until the host draws its first frame */
+		glClear(GL_COLOR_BUFFER_BIT);
+		return;
+	}
+
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, frame_tex);
+	glBegin(GL_QUADS);
+	glTexCoord2f(0, 0);
+	glVertex2f(-1, -1);
+	glTexCoord2f(1, 0);
+	glVertex2f(1, -1);
+	glTexCoord2f(1, 1);
+	glVertex2f(1, 1);
+	glTexCoord2f(0, 1);
+	glVertex2f(-1, 1);
+	glEnd();
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+}
+
+/* runs in the host process: starts the plugin, and draws frames on request
+ * until told to quit, or until xlivebg goes away.
+ */
+static void host_main(void)
+{
+	struct request req;
+	int i, status = 0, quality, stride;
+	uint32_t *pixels;
+
+	in_host = 1;
+
+	/* crash, instead of setting the quit flag of the main loop */
+	signal(SIGINT, SIG_DFL);
+	signal(SIGILL, SIG_DFL);
+	signal(SIGSEGV, SIG_DFL);
+	signal(SIGTERM, SIG_DFL);
+#ifdef __linux__
+	prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+	/* fork without exec keeps every descriptor open, close-on-exec or not.
+	 * Drop the ones xlivebg watches (X connection, control socket and
+	 * clients, plugin directory watch), so that the host can't read from
+	 * them, or keep them alive after xlivebg is gone.
+	 */
+	evloop_after_fork();
+	if(sw_render) {
+		swr_after_fork();
+	} else if(host_init_gl() == -1) {
+		status = -1;
+	}
+
+	if(status != -1) {
+		if(plugin->init && plugin->init(plugin->data) == -1) {
+			status = -1;
+		} else if(plugin->start && plugin->start(msec, plugin->data) == -1) {
+			status = -1;
+		}
+	}
+	if(send_reply(status) == -1 || status == -1) {
+		_exit(1);
+	}
+
+	quality = quality_level();
+	while(read(sock, &req, sizeof req) == sizeof req) {
+		if(req.cmd == HOST_QUIT) {
+			if(plugin->stop) {
+				plugin->stop(plugin->data);
+			}
+			if(plugin->cleanup) {
+				plugin->cleanup(plugin->data);
+			}
+			send_reply(status);
+			break;
+		}
+		if(req.cmd == HOST_CFG) {
+			if(recv_cfg(req.size) == -1 || send_reply(status) == -1) {
+				break;
+			}
+			continue;
+		}
+
+		msec = req.msec;
+		frame_time_usec = req.frame_time;
+		frame_delta_usec = req.frame_delta;
+		frame_count = req.frame_count;
+		mouse_x = req.mouse_x;
+		mouse_y = req.mouse_y;
+
+		num_vis_screens = req.num_vis;
+		memcpy(vis_screen, req.vis, sizeof vis_screen);
+		for(i=0; i<num_screens; i++) {
+			memcpy(screen[i].vport, req.vport[i], sizeof screen[i].vport);
+		}
+
+		if(req.quality != quality && plugin->quality) {
+			quality = req.quality;
+			plugin->quality(quality, plugin->data);
+		}
+
+		if(sw_render) {
+			pixels = swr_framebuffer(&stride);
+			plugin->draw_sw(pixels, stride, req.width, req.height, req.msec, plugin->data);
+		} else {
+			app_draw_plugin(plugin, 0);
+
+			/* the plugin is supposed to leave xlivebg_framebuffer (0 in the
+			 * host) bound, but read from the pbuffer regardless. Nothing else
+			 * uses this context.
+			 */
+			if(xlivebg_gl_bind_framebuffer) {
+				xlivebg_gl_bind_framebuffer(GL_READ_FRAMEBUFFER, 0);
+			}
+			glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+			glPixelStorei(GL_PACK_ALIGNMENT, 4);
+			glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+			glReadPixels(0, 0, req.width, req.height, GL_BGRA, GL_UNSIGNED_BYTE, gl_frame[req.buf]);
+			glPopClientAttrib();
+		}
+
+		if(send_reply(status) == -1) {
+			break;
+		}
+	}
+	_exit(0);
+}
+
+/* opens the OpenGL context of the host. Objects created by xlivebg belong to
+ * its own context, so forget about them, to have them created again in this
+ * one when needed.
+ */
+static int host_init_gl(void)
+{
+	if(xlivebg_init_host_gl(host_width, host_height) == -1) {
+		return -1;
+	}
+	destroy_all_textures();
+	layer_destroy_gl();
+	bgcache_destroy_gl();
+	bgcache_invalidate();
+	rscale_destroy_gl();
+	loopcache_destroy_gl();
+	gl_reset_state(host_width, host_height);
+	return 0;
+}
+
+/* reads the cfg_msg following a HOST_CFG request, and applies it */
+static int recv_cfg(int size)
+{
+	struct cfg_msg *msg;
+	struct ts_value val;
+	char *path, *str;
+
+	if(size <= (int)sizeof *msg || !(msg = malloc(size + 2))) {
+		return -1;
+	}
+	if(read(sock, msg, size) != size) {
+		free(msg);
+		return -1;
+	}
+	path = (char*)(msg + 1);
+	path[size - sizeof *msg] = path[size - sizeof *msg + 1] = 0;
+	str = path + strlen(path) + 1;
+
+	ts_init_value(&val);
+	switch(msg->type) {
+	case -1:
+		break;
+	case TS_NUMBER:
+		if(msg->fnum == (float)msg->inum) {
+			ts_set_valuei(&val, msg->inum);
+		} else {
+			ts_set_valuef(&val, msg->fnum);
+		}
+		break;
+	case TS_VECTOR:
+		ts_set_valuef_arr(&val, msg->vec_size, msg->vec);
+		break;
+	default:
+		ts_set_value_str(&val, str);
+	}
+
+	if(update_hosted_cfg(plugin, path, msg->type == -1 ? 0 : &val) == -1) {
+		fprintf(stderr, "host: failed to update %s\n", path);
+	}
+	ts_destroy_value(&val);
+	free(msg);
+	return 0;
+}
+
+static int send_reply(int status)
+{
+	struct reply rep;
+
+	rep.status = status;
+	rep.upd_interval = plugin->upd_interval;
+	rep.still = still_declared();
+	rep.period = loopcache_period();
+
+	return write(sock, &rep, sizeof rep) == sizeof rep ? 0 : -1;
+}
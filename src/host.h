@@ -0,0 +1,70 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef HOST_H_
+#define HOST_H_
+
+#include "xlivebg.h"
+
+/* Out-of-process plugin hosting. With the isolate.enable option set, the
+ * active plugin runs in a child host process, forked from xlivebg when the
+ * plugin is activated. The host calls init, start, and draw (or draw_sw),
+ * and sends back the state the plugin sets through the API. With the
+ * software renderer it draws directly into the shared memory framebuffer
+ * which xlivebg then presents, so there's no copying involved. With OpenGL
+ * the host opens its own X connection and draws on a pbuffer, and each frame
+ * is read back into one of two shared buffers, and drawn by xlivebg from a
+ * texture, one frame later, so that neither waits for the other. If
+ * the host crashes, or doesn't finish a frame within isolate.timeout
+ * milliseconds, it's killed and restarted, and the rest of xlivebg keeps
+ * running.
+ */
+
+/* forks a host process for plugin, and waits for it to init and start */
+int host_start(struct xlivebg_plugin *plugin);
+/* stops the host process of the active plugin */
+void host_stop(void);
+/* forces a restart of the host, to pick up configuration changes */
+void host_restart(void);
+/* passes a change of a background setting, or of a property of the plugin, on
+ * to the copy of the configuration in the host, which calls the prop callback
+ * of the plugin. tsval is null if the option was removed.
+ */
+struct ts_value;
+void host_setcfg(const char *cfgpath, struct ts_value *tsval);
+
+/* returns non-zero if the active plugin runs in a host process (even if it's
+ * being restarted). Always 0 in the host process itself.
+ */
+int host_active(void);
+
+/* asks the host to draw a frame, and waits for it to finish */
+void host_draw(uint32_t *pixels, int stride, int width, int height);
+/* same for OpenGL, but without waiting: the host is asked to draw the next
+ * frame, while the last complete one is drawn over the current framebuffer,
+ * which is width x height. With wait set, the new frame is waited for and
+ * drawn instead.
+ */
+void host_draw_gl(int width, int height, int wait);
+void host_destroy_gl(void);
+
+/* in the host process, returns the mouse position forwarded by xlivebg, and
+ * non-zero. Returns 0 in xlivebg itself.
+ */
+int host_mouse(int *x, int *y);
+
+#endif	/* HOST_H_ */
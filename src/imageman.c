@@ -22,6 +22,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <imago2.h>
 #include "imageman.h"
 #include "cfg.h"
+#include "gltrack.h"
 
 static int gen_test_image(struct xlivebg_image *img, int width, int height);
 
@@ -206,6 +207,19 @@ struct xlivebg_image *get_image(int idx)
 	return img;
 }
 
+/* removes an image from the list, without freeing it */
+int remove_image(struct xlivebg_image *img)
+{
+	int i;
+	for(i=0; i<num_images; i++) {
+		if(images[i] == img) {
+			images[i] = images[--num_images];
+			return 0;
+		}
+	}
+	return -1;
+}
+
 int get_image_count(void)
 {
 	return num_images;
@@ -299,11 +313,16 @@ void update_texture(struct xlivebg_image *img)
 	if(!img) return;
 
 	if(!img->tex) {
+		/* image textures belong to the core, and are shared by all plugins */
+		void *owner = gltrack_owner(0);
+
 		glGenTextures(1, &img->tex);
 		glBindTexture(GL_TEXTURE_2D, img->tex);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP_SGIS, 1);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, img->width, img->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, img->pixels);
+
+		gltrack_owner(owner);
 	}
 }
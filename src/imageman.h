@@ -34,6 +34,7 @@ int load_image_mem(struct xlivebg_image *img, void *data, long datasz);
 void update_texture(struct xlivebg_image *img);
 
 int add_image(struct xlivebg_image *img);
+int remove_image(struct xlivebg_image *img);
 
 struct xlivebg_image *get_image(int idx);
 int get_image_count(void);
@@ -0,0 +1,392 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opengl.h"
+#include "layer.h"
+#include "app.h"
+#include "cfg.h"
+#include "plugin.h"
+#include "damage.h"
+#include "gltrack.h"
+#include "sched.h"
+#include "rscale.h"
+#include "treestore.h"
+
+#define MAX_LAYERS	8
+
+struct layer {
+	struct xlivebg_plugin *plugin;	/* null for the bottom layer (the active plugin) */
+	int blend;
+	long interval;		/* update interval in microseconds, 0 for static layers */
+	int64_t next;		/* when the next update is due */
+	int valid;			/* the framebuffer holds an up to date frame */
+
+	unsigned int fbo, tex;
+	int width, height;
+};
+
+static int parse_blend(const char *str);
+static int create_target(struct layer *layer);
+static void destroy_target(struct layer *layer);
+
+static struct layer layers[MAX_LAYERS];
+static int num_layers;
+static int cur = -1;		/* layer being drawn, -1 if none */
+static int num_drawn;		/* layers redrawn this frame */
+static void *prev_owner;
+
+
+void layer_setup(void)
+{
+	int i, j, fps, count = 1;
+	struct layer stack[MAX_LAYERS];
+	struct ts_node *node;
+	struct xlivebg_plugin *p;
+	const char *name;
+	static int warned;
+
+	memset(stack, 0, sizeof stack);
+
+	node = cfg.ts && !sw_render && get_active_plugin() ? cfg.ts->child_list : 0;
+	while(node) {
+		if(strcmp(node->name, "layer") != 0 || !(name = ts_get_attr_str(node, "plugin", 0))) {
+			node = node->next;
+			continue;
+		}
+		if(!gl_have_fbo) {
+			if(!warned) {
+				fprintf(stderr, "xlivebg: layers need framebuffer objects, ignoring layer sections\n");
+				warned = 1;
+			}
+			break;
+		}
+		if(count >= MAX_LAYERS) {
+			fprintf(stderr, "xlivebg: too many layers, ignoring %s\n", name);
+			break;
+		}
+		if(!(p = find_plugin(name))) {
+			fprintf(stderr, "xlivebg: layer plugin %s not found\n", name);
+		} else {
+			/* a plugin can only be drawn once */
+			for(i=1; i<count; i++) {
+				if(stack[i].plugin == p) break;
+			}
+			if(i >= count && p != get_active_plugin()) {
+				stack[count].plugin = p;
+				stack[count].blend = parse_blend(ts_get_attr_str(node, "blend", "alpha"));
+				fps = ts_get_attr_int(node, "fps", 0);
+				stack[count].interval = fps > 0 ? 1000000 / fps : p->upd_interval;
+				count++;
+			}
+		}
+		node = node->next;
+	}
+
+	/* stop the layers which aren't in the new stack, and free their framebuffers */
+	for(i=1; i<num_layers; i++) {
+		for(j=1; j<count; j++) {
+			if(stack[j].plugin == layers[i].plugin) break;
+		}
+		if(j >= count) {
+			printf("xlivebg: removing layer: %s\n", layers[i].plugin->name);
+			stop_layer_plugin(layers[i].plugin);
+			destroy_target(layers + i);
+		}
+	}
+
+	/* keep the framebuffers of the ones which stay, and start the new ones */
+	for(i=1; i<count; i++) {
+		for(j=1; j<num_layers; j++) {
+			if(layers[j].plugin == stack[i].plugin) break;
+		}
+		if(j < num_layers) {
+			stack[i].fbo = layers[j].fbo;
+			stack[i].tex = layers[j].tex;
+			stack[i].width = layers[j].width;
+			stack[i].height = layers[j].height;
+			continue;
+		}
+
+		printf("xlivebg: adding layer: %s\n", stack[i].plugin->name);
+		if(!(stack[i].plugin = start_layer_plugin(stack[i].plugin))) {
+			memmove(stack + i, stack + i + 1, (count - i - 1) * sizeof *stack);
+			count--;
+			i--;
+		}
+	}
+
+	if(count > 1) {
+		stack[0].fbo = layers[0].fbo;
+		stack[0].tex = layers[0].tex;
+		stack[0].width = layers[0].width;
+		stack[0].height = layers[0].height;
+	} else {
+		destroy_target(layers);
+	}
+
+	if((count > 1) != (num_layers > 1)) {
+		/* switching between compositing and drawing directly on the window */
+		damage_invalidate();
+	}
+	memcpy(layers, stack, count * sizeof *layers);
+	num_layers = count;
+}
+
+void layer_remove(struct xlivebg_plugin *plugin)
+{
+	int i;
+
+	for(i=1; i<num_layers; i++) {
+		if(layers[i].plugin == plugin) {
+			printf("xlivebg: removing layer: %s\n", plugin->name);
+			stop_layer_plugin(plugin);
+			destroy_target(layers + i);
+
+			memmove(layers + i, layers + i + 1, (num_layers - i - 1) * sizeof *layers);
+			if(--num_layers <= 1) {
+				destroy_target(layers);
+				damage_invalidate();
+			}
+			return;
+		}
+	}
+}
+
+void layer_destroy_gl(void)
+{
+	int i;
+
+	for(i=0; i<num_layers; i++) {
+		destroy_target(layers + i);
+	}
+}
+
+int layer_count(void)
+{
+	return num_layers > 1 && get_active_plugin() ? num_layers : 0;
+}
+
+struct xlivebg_plugin *layer_plugin(int idx)
+{
+	return idx ? layers[idx].plugin : get_active_plugin();
+}
+
+void layer_invalidate(void)
+{
+	int i;
+
+	for(i=0; i<num_layers; i++) {
+		layers[i].valid = 0;
+	}
+}
+
+long layer_frame_interval(long interval)
+{
+	int i;
+	long min = interval;
+
+	if(num_layers <= 1) {
+		return interval;
+	}
+
+	layers[0].interval = interval;
+	for(i=1; i<num_layers; i++) {
+		if(layers[i].interval > 0 && (min <= 0 || layers[i].interval < min)) {
+			min = layers[i].interval;
+		}
+	}
+	return min;
+}
+
+int layer_begin(int idx, int64_t now)
+{
+	struct layer *layer = layers + idx;
+	int width = rscale_width();
+	int height = rscale_height();
+
+	if(layer->fbo && (layer->width != width || layer->height != height)) {
+		destroy_target(layer);
+	}
+	if(!layer->fbo) {
+		/* don't retry a failed framebuffer until the size changes */
+		if(layer->width == width && layer->height == height) {
+			return 0;
+		}
+		if(create_target(layer) == -1) {
+			return 0;
+		}
+	}
+
+	if(layer->valid && (layer->interval <= 0 || layer->next - sched_interval() / 2 > now)) {
+		return 0;
+	}
+	layer->next += layer->interval;
+	if(layer->next <= now) {
+		layer->next = now + layer->interval;
+	}
+
+	/* each layer starts from the baseline state, as if it was the only one */
+	gl_reset_state(width, height);
+	xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, layer->fbo);
+
+	/* GL objects created while drawing belong to the plugin of the layer */
+	prev_owner = gltrack_owner(layer_plugin(idx));
+	cur = idx;
+	return 1;
+}
+
+void layer_end(void)
+{
+	if(cur < 0) return;
+
+	gltrack_owner(prev_owner);
+	layers[cur].valid = 1;
+	num_drawn++;
+	cur = -1;
+}
+
+int layer_valid(int idx)
+{
+	return layers[idx].valid;
+}
+
+void layer_composite(void)
+{
+	int i;
+	struct layer *layer;
+
+	if(!num_drawn && damage_partial()) {
+		/* every layer was cached, the window already shows this frame */
+		damage_add(0, 0, 0, 0);
+		return;
+	}
+	num_drawn = 0;
+
+	gl_reset_state(rscale_width(), rscale_height());
+	if(rscale_active()) {
+		xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, rscale_framebuffer());
+	}
+	glEnable(GL_TEXTURE_2D);
+
+	for(i=0; i<num_layers; i++) {
+		layer = layers + i;
+		if(!layer->fbo) continue;
+
+		if(i > 0) {
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_ONE, layer->blend == LAYER_BLEND_ADD ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+		}
+
+		glBindTexture(GL_TEXTURE_2D, layer->tex);
+		glBegin(GL_QUADS);
+		glTexCoord2f(0, 0);
+		glVertex2f(-1, -1);
+		glTexCoord2f(1, 0);
+		glVertex2f(1, -1);
+		glTexCoord2f(1, 1);
+		glVertex2f(1, 1);
+		glTexCoord2f(0, 1);
+		glVertex2f(-1, 1);
+		glEnd();
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+	glDisable(GL_BLEND);
+
+	/* the whole window changed, whatever the layers reported */
+	damage_add(0, 0, scr_width, scr_height);
+}
+
+unsigned int layer_framebuffer(void)
+{
+	return cur >= 0 ? layers[cur].fbo : 0;
+}
+
+static int parse_blend(const char *str)
+{
+	if(strcasecmp(str, "alpha") == 0) {
+		return LAYER_BLEND_ALPHA;
+	}
+	if(strcasecmp(str, "add") == 0) {
+		return LAYER_BLEND_ADD;
+	}
+	fprintf(stderr, "xlivebg: invalid layer blend mode: %s\n", str);
+	return LAYER_BLEND_ALPHA;
+}
+
+static int create_target(struct layer *layer)
+{
+	void *owner;
+	unsigned int status;
+	int width = rscale_width();
+	int height = rscale_height();
+
+	/* the framebuffers belong to the core, not the plugin being drawn */
+	owner = gltrack_owner(0);
+	glGenTextures(1, &layer->tex);
+	gltrack_owner(owner);
+
+	glBindTexture(GL_TEXTURE_2D, layer->tex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	xlivebg_gl_gen_framebuffers(1, &layer->fbo);
+	xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, layer->fbo);
+	xlivebg_gl_framebuffer_texture_2d(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, layer->tex, 0);
+	status = xlivebg_gl_check_framebuffer_status(GL_FRAMEBUFFER);
+	if(status == GL_FRAMEBUFFER_COMPLETE) {
+		glClearColor(0, 0, 0, 0);
+		glClear(GL_COLOR_BUFFER_BIT);
+	}
+	xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+
+	if(status != GL_FRAMEBUFFER_COMPLETE) {
+		fprintf(stderr, "xlivebg: failed to create %dx%d layer framebuffer (status: %x)\n",
+				width, height, status);
+		destroy_target(layer);
+		layer->width = width;
+		layer->height = height;
+		return -1;
+	}
+
+	layer->width = width;
+	layer->height = height;
+	layer->valid = 0;
+	return 0;
+}
+
+static void destroy_target(struct layer *layer)
+{
+	if(layer->fbo) {
+		xlivebg_gl_delete_framebuffers(1, &layer->fbo);
+		layer->fbo = 0;
+	}
+	if(layer->tex) {
+		glDeleteTextures(1, &layer->tex);
+		layer->tex = 0;
+	}
+	layer->width = layer->height = 0;
+	layer->valid = 0;
+}
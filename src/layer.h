@@ -0,0 +1,77 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef LAYER_H_
+#define LAYER_H_
+
+#include "xlivebg.h"
+
+/* Layer stack. The active plugin is the bottom layer, and the plugins listed
+ * in the layer sections of the config file are stacked on top of it, in
+ * order. While there's more than one layer, each one renders into its own
+ * framebuffer object, at its own update interval, and the core blends them
+ * onto the window. Layers which don't request updates (XLIVEBG_NOUPD) are
+ * drawn once and cached until invalidated, so only the layers which changed
+ * are redrawn. Needs framebuffer objects, and isn't available with the
+ * software renderer.
+ */
+enum {
+	LAYER_BLEND_ALPHA,	/* premultiplied alpha */
+	LAYER_BLEND_ADD
+};
+
+/* rebuilds the stack from the config file and the active plugin, starting
+ * and stopping the plugins of the layers above it as needed.
+ */
+void layer_setup(void);
+/* stops the plugin if it's drawn as a layer above the active one, and drops
+ * it from the stack.
+ */
+void layer_remove(struct xlivebg_plugin *plugin);
+/* frees the framebuffers, with the OpenGL context still current */
+void layer_destroy_gl(void);
+
+/* number of layers, including the active plugin. 0 if there's nothing to
+ * composite, and the active plugin draws directly on the window.
+ */
+int layer_count(void);
+struct xlivebg_plugin *layer_plugin(int idx);
+
+/* forces all layers to be redrawn with the next frame */
+void layer_invalidate(void);
+
+/* sets the update interval of the bottom layer, and returns the frame
+ * interval: the shortest update interval of all the layers.
+ */
+long layer_frame_interval(long interval);
+
+/* if layer idx is due for an update, or its cached frame is out of date,
+ * resets the OpenGL state, binds the framebuffer of the layer, and returns 1.
+ * Otherwise returns 0, and the cached frame is reused.
+ */
+int layer_begin(int idx, int64_t now);
+void layer_end(void);
+/* returns non-zero if the framebuffer of layer idx holds its previous frame */
+int layer_valid(int idx);
+
+/* blends all the layers onto the window */
+void layer_composite(void);
+
+/* returns the framebuffer object of the layer being drawn, 0 if none */
+unsigned int layer_framebuffer(void);
+
+#endif	/* LAYER_H_ */
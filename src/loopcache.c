@@ -0,0 +1,222 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "opengl.h"
+#include "loopcache.h"
+#include "app.h"
+#include "cfg.h"
+#include "layer.h"
+#include "rscale.h"
+#include "gltrack.h"
+
+#define MAX_FRAMES	4096
+
+static int setup(void);
+static int frame_index(unsigned long t);
+
+static long period;			/* in milliseconds, 0 if not periodic */
+static int disabled;		/* a full period doesn't fit in the budget */
+
+static unsigned int *frames;	/* one texture per frame, 0 until stored */
+static int num_frames, num_stored;
+static int width, height;
+static int compress;		/* frames are stored DXT1 compressed */
+static int cur = -1;		/* frame being drawn for loopcache_store */
+
+
+void loopcache_reset(void)
+{
+	period = 0;
+	loopcache_invalidate();
+}
+
+void loopcache_set_period(long msec)
+{
+	if(msec < 0) msec = 0;
+	if(msec == period) return;
+
+	period = msec;
+	loopcache_invalidate();
+	if(period) {
+		printf("xlivebg: animation loops every %ld ms\n", period);
+	}
+}
+
+long loopcache_period(void)
+{
+	return period;
+}
+
+void loopcache_invalidate(void)
+{
+	int i;
+
+	if(frames) {
+		for(i=0; i<num_frames; i++) {
+			if(frames[i]) glDeleteTextures(1, frames + i);
+		}
+		free(frames);
+		frames = 0;
+	}
+	num_frames = num_stored = 0;
+	disabled = 0;
+	cur = -1;
+}
+
+void loopcache_destroy_gl(void)
+{
+	loopcache_invalidate();
+}
+
+int loopcache_active(void)
+{
+	return period > 0 && cfg.loop_budget > 0 && !sw_render && !layer_count() && !disabled;
+}
+
+int loopcache_need(unsigned long t, unsigned long *frame_t)
+{
+	*frame_t = t;
+	cur = -1;
+
+	if(!frames && setup() == -1) {
+		return 1;
+	}
+
+	cur = frame_index(t);
+	if(frames[cur]) {
+		return 0;
+	}
+	*frame_t = (unsigned long)((double)cur * period / num_frames);
+	return 1;
+}
+
+long loopcache_frame_interval(void)
+{
+	return num_frames ? (long)((double)period * 1000.0 / num_frames) : 0;
+}
+
+void loopcache_store(void)
+{
+	void *owner;
+
+	if(cur < 0 || frames[cur]) return;
+
+	gl_reset_state(width, height);
+	if(rscale_active()) {
+		xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, rscale_framebuffer());
+	}
+
+	/* the frames belong to the core, not the plugin being drawn */
+	owner = gltrack_owner(0);
+	glGenTextures(1, frames + cur);
+	gltrack_owner(owner);
+
+	glBindTexture(GL_TEXTURE_2D, frames[cur]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glCopyTexImage2D(GL_TEXTURE_2D, 0, compress ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGB,
+			0, 0, width, height, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if(++num_stored == num_frames) {
+		printf("xlivebg: loop of %d frames cached, playing back\n", num_frames);
+	}
+	cur = -1;
+}
+
+void loopcache_draw(unsigned long t)
+{
+	int idx = frame_index(t);
+
+	gl_reset_state(width, height);
+	if(rscale_active()) {
+		xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, rscale_framebuffer());
+	}
+
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, frames[idx]);
+	glBegin(GL_QUADS);
+	glTexCoord2f(0, 0);
+	glVertex2f(-1, -1);
+	glTexCoord2f(1, 0);
+	glVertex2f(1, -1);
+	glTexCoord2f(1, 1);
+	glVertex2f(1, 1);
+	glTexCoord2f(0, 1);
+	glVertex2f(-1, 1);
+	glEnd();
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+}
+
+/* one frame per update interval of the plugin, if a full period fits in the
+ * memory budget.
+ */
+static int setup(void)
+{
+	long interval, frame_size, total;
+
+	interval = cfg.fps_override > 0 ? cfg.fps_override_interval : upd_interval_usec;
+	if(interval <= 0) {
+		/* not animated, nothing to cache */
+		disabled = 1;
+		return -1;
+	}
+
+	width = rscale_width();
+	height = rscale_height();
+	compress = cfg.loop_compress && gl_have_s3tc;
+	if(compress) {
+		/* DXT1: 8 bytes per 4x4 block */
+		frame_size = ((width + 3) / 4) * ((height + 3) / 4) * 8;
+	} else {
+		frame_size = width * height * 4;
+	}
+
+	num_frames = (int)(((double)period * 1000.0 + interval - 1) / interval);
+	if(num_frames < 2) num_frames = 2;
+	total = (long)((double)num_frames * frame_size / (1024.0 * 1024.0));
+
+	if(num_frames > MAX_FRAMES || total > cfg.loop_budget) {
+		printf("xlivebg: loop of %d frames needs %ld MB, over the %d MB budget, not caching\n",
+				num_frames, total, cfg.loop_budget);
+		num_frames = 0;
+		disabled = 1;
+		return -1;
+	}
+
+	if(!(frames = calloc(num_frames, sizeof *frames))) {
+		fprintf(stderr, "xlivebg: failed to allocate loop cache\n");
+		num_frames = 0;
+		disabled = 1;
+		return -1;
+	}
+	printf("xlivebg: caching a loop of %d frames (%ld MB%s)\n", num_frames, total,
+			gl_have_s3tc ? ", compressed" : "");
+	num_stored = 0;
+	return 0;
+}
+
+static int frame_index(unsigned long t)
+{
+	int idx = (int)((double)(t % period) * num_frames / period);
+	return idx < num_frames ? idx : num_frames - 1;
+}
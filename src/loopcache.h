@@ -0,0 +1,60 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef LOOPCACHE_H_
+#define LOOPCACHE_H_
+
+/* Loop cache. Plugins whose animation repeats exactly (colcycle palettes for
+ * instance) report their period with xlivebg_set_period. Every frame of one
+ * period, at the update interval of the plugin, is then kept in a texture
+ * (DXT1 compressed, if available), filled in as each one comes up for the
+ * first time, and played back from then on, instead of drawing the plugin
+ * again. Frames are dropped whenever something changes what the plugin
+ * draws (properties, outputs, window size). The cache is skipped if a full
+ * period doesn't fit in the loop_cache.budget memory limit, while layers are
+ * stacked on top, and with the software renderer.
+ */
+
+/* forgets the period of the previous plugin, when a new one is activated */
+void loopcache_reset(void);
+
+/* called by the active plugin, with the period of its animation in
+ * milliseconds, or 0 if it's not periodic.
+ */
+void loopcache_set_period(long msec);
+long loopcache_period(void);
+
+/* drops all cached frames */
+void loopcache_invalidate(void);
+void loopcache_destroy_gl(void);
+
+/* returns non-zero if frames go through the cache */
+int loopcache_active(void);
+
+/* returns non-zero if the frame for time t isn't cached yet, and has to be
+ * drawn by the plugin at time frame_t (the start of its frame interval), and
+ * then passed to loopcache_store.
+ */
+int loopcache_need(unsigned long t, unsigned long *frame_t);
+/* returns the time between cached frames in microseconds */
+long loopcache_frame_interval(void);
+/* keeps the frame just drawn, from the current framebuffer */
+void loopcache_store(void);
+/* draws the cached frame for time t */
+void loopcache_draw(unsigned long t);
+
+#endif	/* LOOPCACHE_H_ */
@@ -20,8 +20,6 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <string.h>
 #include <assert.h>
 #include <signal.h>
-#include <sys/select.h>
-#include <sys/time.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <X11/Xatom.h>
@@ -34,8 +32,31 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "app.h"
 #include "xlivebg.h"
 #include "cfg.h"
+#include "plugin.h"
 #include "ctrl.h"
 #include "imageman.h"
+#include "sched.h"
+#include "evloop.h"
+#include "cover.h"
+#include "power.h"
+#include "stats.h"
+#include "damage.h"
+#include "swrender.h"
+#include "capture.h"
+#include "quality.h"
+#include "bench.h"
+#include "timesrc.h"
+#include "layer.h"
+#include "bgcache.h"
+#include "rscale.h"
+#include "loopcache.h"
+#include "still.h"
+#include "bake.h"
+#include "host.h"
+
+/* offscreen framebuffer size used for benchmarking */
+#define BENCH_WIDTH		1920
+#define BENCH_HEIGHT	1080
 
 /* create_xwindow flags */
 enum {
@@ -54,6 +75,14 @@ static XVisualInfo *choose_visual(void);
 #ifdef HAVE_XRANDR
 static void detect_outputs(void);
 #endif
+static int bench_main(int argc, char **argv);
+static int bake_main(int argc, char **argv);
+static int create_pbuffer(int width, int height);
+static int init_gl_pbuffer(void);
+static int init_gl_window(void);
+static int init_sw(Window win, int width, int height);
+static void init_single_screen(int width, int height);
+static void set_suspended(int susp);
 static int proc_xevent(XEvent *ev);
 static void send_expose(Window win);
 static void sighandler(int s);
@@ -71,17 +100,23 @@ static int have_xrandr, xrandr_evbase, xrandr_errbase;
 #endif
 
 static volatile int quit;
-static int mapped;
+static int mapped, obscured, suspended;
 static int win_width, win_height;
 static int dblbuf;
 static int opt_new_win, opt_preview;
 static Window new_win_parent;
+static const char *opt_bench;
+static long opt_bench_frames;
+static int opt_bake;
+
+static GLXPbuffer pbuf;
+static GLXFBConfig pbuf_fbconf;
 
-static struct timeval tv, tv0;
 
 int main(int argc, char **argv)
 {
 	int xfd, len;
+	int64_t now;
 	XWindowAttributes attr;
 
 	len = strlen(argv[0]);
@@ -112,6 +147,17 @@ int main(int argc, char **argv)
 	scr_width = attr.width;
 	scr_height = attr.height;
 
+	if(opt_bench) {
+		int res = bench_main(argc, argv);
+		XCloseDisplay(dpy);
+		return res;
+	}
+	if(opt_bake) {
+		int res = bake_main(argc, argv);
+		XCloseDisplay(dpy);
+		return res;
+	}
+
 	xa_wm_proto = XInternAtom(dpy, "WM_PROTOCOLS", False);
 	xa_wm_delwin = XInternAtom(dpy, "WM_DELETE_WINDOW", False);
 
@@ -135,7 +181,9 @@ int main(int argc, char **argv)
 			printf("detected root window: %x\n", (unsigned int)win);
 		}
 	}
-	XSelectInput(dpy, win, ExposureMask | StructureNotifyMask);
+	XSelectInput(dpy, win, ExposureMask | StructureNotifyMask | VisibilityChangeMask);
+	XGetWindowAttributes(dpy, win, &attr);
+	mapped = attr.map_state != IsUnmapped;
 
 	signal(SIGINT, sighandler);
 	signal(SIGILL, sighandler);
@@ -145,8 +193,14 @@ int main(int argc, char **argv)
 
 	init_cfg();
 
+	if(evloop_init() == -1 || evloop_add(xfd, 0, 0) == -1) {
+		XCloseDisplay(dpy);
+		return 1;
+	}
+
 	if(ctrl_init() == -1) {
 		fprintf(stderr, "Failed to create control socket, is xlivebg already running?\n");
+		evloop_shutdown();
 		XCloseDisplay(dpy);
 		return 1;
 	}
@@ -159,31 +213,30 @@ int main(int argc, char **argv)
 	} else
 #endif
 	{
-		num_screens = 1;
-		screen[0].x = screen[0].y = 0;
-		screen[0].width = screen[0].root_width = scr_width;
-		screen[0].height = screen[0].root_height = scr_height;
-		screen[0].aspect = (float)scr_width / (float)scr_height;
-		screen[0].vport[0] = screen[0].vport[1] = 0;
-		screen[0].vport[2] = scr_width;
-		screen[0].vport[3] = scr_height;
-		printf("output: %dx%d\n", scr_width, scr_height);
+		init_single_screen(scr_width, scr_height);
+	}
+	update_visible_screens(0);
+
+	if(!opt_preview) {
+		cover_init(dpy, root, win);
+		power_init(dpy, root);
 	}
 
 	if(app_init(argc, argv) == -1) {
 		ctrl_shutdown();
+		evloop_shutdown();
 		XCloseDisplay(dpy);
 		return 1;
 	}
 
-	gettimeofday(&tv0, 0);
+	now = sched_time_usec();
+	sched_reset(now);
+	timesrc_reset(now);
+	stats_reset();
 
 	while(!quit) {
-		fd_set rdset;
-		struct timeval *timeout;
-		int i, max_fd, num_ctrl_sock;
+		int64_t wait_until, next_poll;
 		long interval;
-		int *ctrl_sock;
 
 		while(XPending(dpy)) {
 			XEvent ev;
@@ -193,66 +246,83 @@ int main(int argc, char **argv)
 			}
 		}
 
-		gettimeofday(&tv, 0);
-		msec = (tv.tv_sec - tv0.tv_sec) * 1000 + (tv.tv_usec - tv0.tv_usec) / 1000;
-
-		app_draw();
-		if(dblbuf) {
-			glXSwapBuffers(dpy, win);
-		} else {
-			glFlush();
-		}
-
-		/* wait for as long as requested by the live wallpaper, or until an
-		 * event arrives
+		/* throttle down when the user is idle, and stop completely while the
+		 * screensaver is active or the monitors are powered down.
+		 */
+		now = sched_time_usec();
+		power_update(now);
+		cleanup_inactive_plugins(now);
+		interval = app_frame_interval(cfg.fps_override > 0 ? cfg.fps_override_interval : upd_interval_usec);
+		interval = still_interval(interval);
+		interval = power_interval(interval);
+		next_poll = power_next_poll();
+
+		/* don't draw anything while our window is unmapped, fully obscured,
+		 * or when every output is covered by fullscreen windows. Just block
+		 * until something changes, or until it's time to poll the power
+		 * state again.
 		 */
-		FD_ZERO(&rdset);
-		FD_SET(xfd, &rdset);
-		max_fd = xfd;
-
-		ctrl_sock = ctrl_sockets(&num_ctrl_sock);
-		for(i=0; i<num_ctrl_sock; i++) {
-			int s = ctrl_sock[i];
-			FD_SET(s, &rdset);
-			if(s > max_fd) max_fd = s;
+		set_suspended(!mapped || obscured || !num_vis_screens || interval < 0);
+		if(suspended) {
+			evloop_wait(next_poll);
+			continue;
 		}
+		sched_set_interval(interval);
 
-		interval = (cfg.fps_override > 0) ? cfg.fps_override_interval : upd_interval_usec;
-
-		if(interval > 0) {
-			struct timeval now;
-			long usec;
-
-			gettimeofday(&now, 0);
-
-			usec = interval - (now.tv_sec - tv.tv_sec) * 1000000 - (now.tv_usec - tv.tv_usec);
-			if(usec < 0) usec = 0;
+		/* a static frame is only redrawn when something changed, the loop
+		 * just waits for events in the meantime.
+		 */
+		now = sched_time_usec();
+		still_update(now);
+		if(sched_due(now) && !still_skip()) {
+			app_frame_time(timesrc_frame(now));
+
+			stats_frame_begin(now);
+			damage_frame_begin();
+			app_draw();
+			stats_draw_done(sched_time_usec());
+			capture_frame(sched_time_usec());
+			still_frame();
+
+			if(sw_render) {
+				swr_present();
+			} else if(dblbuf) {
+				damage_present();
+			} else {
+				glFlush();
+			}
 
-			tv.tv_sec = usec / 1000000;
-			tv.tv_usec = usec % 1000000;
-			timeout = &tv;
-		} else {
-			timeout = 0;
+			now = sched_time_usec();
+			stats_frame_end(now);
+			quality_update();
+			sched_frame_done(now);
 		}
 
-		if(select(max_fd + 1, &rdset, 0, 0, timeout) > 0) {
-			/* ignore X events, we'll just handle those at the top of the loop
-			 * shortly. just handle control socket input
-			 */
-			for(i=0; i<num_ctrl_sock; i++) {
-				if(FD_ISSET(ctrl_sock[i], &rdset)) {
-					ctrl_process(ctrl_sock[i]);
-				}
-			}
+		/* wait until the next frame deadline, or until an event arrives. X
+		 * events are handled at the top of the loop, everything else is
+		 * dispatched to the callbacks registered with the event loop.
+		 */
+		wait_until = sched_deadline();
+		if(next_poll >= 0 && (wait_until < 0 || next_poll < wait_until)) {
+			wait_until = next_poll;
+		}
+		next_poll = still_next_poll();
+		if(next_poll >= 0 && (wait_until < 0 || next_poll < wait_until)) {
+			wait_until = next_poll;
 		}
+		now = sched_time_usec();
+		evloop_wait(wait_until);
+		stats_sleep(sched_time_usec() - now);
 	}
 
 done:
 	ctrl_shutdown();
+	evloop_shutdown();
 	send_expose(win);
 	if(visinf) {
 		XFree(visinf);
 	}
+	capture_stop();
 	xlivebg_destroy_gl();
 	if(opt_new_win) {
 		XDestroyWindow(dpy, win);
@@ -261,6 +331,185 @@ done:
 	return 0;
 }
 
+/* benchmark mode: draw the requested plugin on an offscreen pbuffer, on a
+ * fixed virtual clock, as fast as possible.
+ */
+static int bench_main(int argc, char **argv)
+{
+	int res;
+	long step;
+
+	/* the software renderer draws into an offscreen framebuffer of its own */
+	if(!sw_render && create_pbuffer(BENCH_WIDTH, BENCH_HEIGHT) == -1) {
+		return 1;
+	}
+	init_single_screen(BENCH_WIDTH, BENCH_HEIGHT);
+	update_visible_screens(0);
+
+	init_cfg();
+	free(cfg.act_plugin);
+	cfg.act_plugin = strdup(opt_bench);
+
+	if(evloop_init() == -1) {
+		if(pbuf) glXDestroyPbuffer(dpy, pbuf);
+		return 1;
+	}
+	if(app_init(argc, argv) == -1) {
+		evloop_shutdown();
+		if(pbuf) glXDestroyPbuffer(dpy, pbuf);
+		return 1;
+	}
+
+	step = cfg.fps_override > 0 ? cfg.fps_override_interval : upd_interval_usec;
+	if(step <= 0) {
+		step = 1000000 / 60;
+	}
+	/* benchmarks run on the fixed clock, unless another one was requested */
+	if(timesrc_mode() == TIMESRC_REAL) {
+		char buf[64];
+		sprintf(buf, "fixed:%ld", step);
+		timesrc_set(buf);
+	}
+	res = bench_run(opt_bench, opt_bench_frames);
+
+	evloop_shutdown();
+	xlivebg_destroy_gl();
+	if(pbuf) glXDestroyPbuffer(dpy, pbuf);
+	return res == -1 ? 1 : 0;
+}
+
+/* bake mode: draw one frame of the active plugin offscreen, at the size of
+ * the root window, leave it as the root window background, and exit.
+ */
+static int bake_main(int argc, char **argv)
+{
+	int res;
+
+	if(!sw_render && create_pbuffer(scr_width, scr_height) == -1) {
+		return 1;
+	}
+
+	init_cfg();
+
+#ifdef HAVE_XRANDR
+	if((have_xrandr = XRRQueryExtension(dpy, &xrandr_evbase, &xrandr_errbase))) {
+		detect_outputs();
+	} else
+#endif
+	{
+		init_single_screen(scr_width, scr_height);
+	}
+	update_visible_screens(0);
+
+	if(evloop_init() == -1) {
+		if(pbuf) glXDestroyPbuffer(dpy, pbuf);
+		return 1;
+	}
+	if(app_init(argc, argv) == -1 || !get_active_plugin()) {
+		evloop_shutdown();
+		if(pbuf) glXDestroyPbuffer(dpy, pbuf);
+		return 1;
+	}
+
+	res = bake_run(dpy, root);
+
+	evloop_shutdown();
+	xlivebg_destroy_gl();
+	if(pbuf) glXDestroyPbuffer(dpy, pbuf);
+	return res == -1 ? 1 : 0;
+}
+
+static int create_pbuffer(int width, int height)
+{
+	int num_conf;
+	GLXFBConfig *conf;
+	int glxattr[] = {
+		GLX_DRAWABLE_TYPE, GLX_PBUFFER_BIT,
+		GLX_RENDER_TYPE, GLX_RGBA_BIT,
+		GLX_RED_SIZE, 1,
+		GLX_GREEN_SIZE, 1,
+		GLX_BLUE_SIZE, 1,
+		GLX_DEPTH_SIZE, 1,
+		None
+	};
+	int pbattr[] = {
+		GLX_PBUFFER_WIDTH, 0,
+		GLX_PBUFFER_HEIGHT, 0,
+		None
+	};
+	pbattr[1] = width;
+	pbattr[3] = height;
+
+	if(!(conf = glXChooseFBConfig(dpy, scr, glxattr, &num_conf)) || !num_conf) {
+		fprintf(stderr, "failed to find a framebuffer configuration for offscreen rendering\n");
+		return -1;
+	}
+	pbuf_fbconf = conf[0];
+	XFree(conf);
+
+	if(!(pbuf = glXCreatePbuffer(dpy, pbuf_fbconf, pbattr))) {
+		fprintf(stderr, "failed to create %dx%d pbuffer\n", width, height);
+		return -1;
+	}
+	return 0;
+}
+
+static int init_gl_pbuffer(void)
+{
+	unsigned int width, height;
+
+	if(!(ctx = glXCreateNewContext(dpy, pbuf_fbconf, GLX_RGBA_TYPE, 0, True))) {
+		fprintf(stderr, "failed to create OpenGL context for the pbuffer\n");
+		return -1;
+	}
+	glXMakeContextCurrent(dpy, pbuf, pbuf, ctx);
+	dblbuf = 0;
+	init_opengl();
+	stats_init_gl();
+
+	glXQueryDrawable(dpy, pbuf, GLX_WIDTH, &width);
+	glXQueryDrawable(dpy, pbuf, GLX_HEIGHT, &height);
+	app_reshape(width, height);
+	return 0;
+}
+
+static void init_single_screen(int width, int height)
+{
+	num_screens = 1;
+	screen[0].x = screen[0].y = 0;
+	screen[0].width = screen[0].root_width = width;
+	screen[0].height = screen[0].root_height = height;
+	screen[0].aspect = (float)width / (float)height;
+	screen[0].vport[0] = screen[0].vport[1] = 0;
+	screen[0].vport[2] = width;
+	screen[0].vport[3] = height;
+	printf("output: %dx%d\n", width, height);
+}
+
+static void set_suspended(int susp)
+{
+	int64_t now;
+
+	if(susp == suspended) return;
+	suspended = susp;
+
+	now = sched_time_usec();
+	if(susp) {
+		timesrc_pause(now);
+	} else {
+		/* leave the time spent suspended out of msec, to resume animations
+		 * exactly where they left off.
+		 */
+		timesrc_resume(now);
+		sched_reset(now);
+		stats_break();
+		quality_reset();
+		damage_invalidate();
+	}
+	printf("xlivebg: %s drawing\n", susp ? "suspending" : "resuming");
+	app_suspend(susp);
+}
+
 void app_quit(void)
 {
 	quit = 1;
@@ -314,7 +563,7 @@ static Window create_xwindow(int width, int height, unsigned int flags)
 		return 0;
 	}
 
-	evmask = ExposureMask | StructureNotifyMask | KeyPressMask;
+	evmask = ExposureMask | StructureNotifyMask | VisibilityChangeMask | KeyPressMask;
 	XSelectInput(dpy, win, evmask);
 
 	XmbSetWMProperties(dpy, win, "xlivebg", "xlivebg", 0, 0, 0, 0, 0);
@@ -363,7 +612,20 @@ static XVisualInfo *choose_visual(void)
 	};
 	int *sample_buffers = glxattr + 10;
 	int *num_samples = glxattr + 13;
-	XVisualInfo *res;
+	XVisualInfo *res, vitmpl;
+	int numvi;
+
+	if(sw_render) {
+		/* the software renderer needs a 24bit xRGB visual */
+		vitmpl.screen = scr;
+		vitmpl.depth = 24;
+		vitmpl.class = TrueColor;
+		vitmpl.red_mask = 0xff0000;
+		vitmpl.green_mask = 0xff00;
+		vitmpl.blue_mask = 0xff;
+		return XGetVisualInfo(dpy, VisualScreenMask | VisualDepthMask | VisualClassMask |
+				VisualRedMaskMask | VisualGreenMaskMask | VisualBlueMaskMask, &vitmpl, &numvi);
+	}
 
 	do {
 		res = glXChooseVisual(dpy, scr, glxattr);
@@ -376,7 +638,46 @@ static XVisualInfo *choose_visual(void)
 	return res;
 }
 
+/* creates the OpenGL context, or the software framebuffer if we're using the
+ * software renderer. Falls back to software rendering if there's no usable
+ * OpenGL implementation.
+ */
 int xlivebg_init_gl(void)
+{
+	XWindowAttributes wattr;
+
+	if(opt_bench) {
+		return sw_render ? init_sw(0, BENCH_WIDTH, BENCH_HEIGHT) : init_gl_pbuffer();
+	}
+	if(opt_bake) {
+		/* scr_width/scr_height are still the dimensions of the root window */
+		return sw_render ? init_sw(0, scr_width, scr_height) : init_gl_pbuffer();
+	}
+
+	if(!sw_render) {
+		if(init_gl_window() != -1) {
+			return 0;
+		}
+		fprintf(stderr, "falling back to software rendering\n");
+		sw_render = 1;
+	}
+
+	XGetWindowAttributes(dpy, win, &wattr);
+	printf("window size: %dx%d\n", wattr.width, wattr.height);
+	return init_sw(win, wattr.width, wattr.height);
+}
+
+static int init_sw(Window win, int width, int height)
+{
+	if(swr_init(dpy, win, width, height) == -1) {
+		return -1;
+	}
+	dblbuf = 0;
+	app_reshape(width, height);
+	return 0;
+}
+
+static int init_gl_window(void)
 {
 	XVisualInfo *vi, vitmpl;
 	int numvi, val, rbits, gbits, bbits, zbits;
@@ -422,6 +723,10 @@ int xlivebg_init_gl(void)
 	}
 	glXMakeCurrent(dpy, win, ctx);
 	init_opengl();
+	stats_init_gl();
+	if(dblbuf) {
+		damage_init(dpy, win);
+	}
 	app_reshape(wattr.width, wattr.height);
 	XFree(vi);
 	return 0;
@@ -429,12 +734,58 @@ int xlivebg_init_gl(void)
 
 void xlivebg_destroy_gl(void)
 {
+	if(sw_render) {
+		swr_destroy();
+		return;
+	}
+
 	destroy_all_textures();
+	stats_destroy_gl();
+	layer_destroy_gl();
+	bgcache_destroy_gl();
+	rscale_destroy_gl();
+	loopcache_destroy_gl();
+	host_destroy_gl();
 
 	glXMakeCurrent(dpy, 0, 0);
 	glXDestroyContext(dpy, ctx);
 }
 
+void xlivebg_bind_gl(int bind)
+{
+	if(sw_render) return;
+
+	if(!bind) {
+		glXMakeCurrent(dpy, 0, 0);
+	} else if(pbuf) {
+		glXMakeContextCurrent(dpy, pbuf, pbuf, ctx);
+	} else {
+		glXMakeCurrent(dpy, win, ctx);
+	}
+}
+
+int xlivebg_init_host_gl(int width, int height)
+{
+	/* the inherited connection is xlivebg's, and its socket is closed by now */
+	if(!(dpy = XOpenDisplay(DisplayString(dpy)))) {
+		fprintf(stderr, "host: failed to open connection to the X server\n");
+		return -1;
+	}
+	scr = DefaultScreen(dpy);
+	root = RootWindow(dpy, scr);
+
+	if(create_pbuffer(width, height) == -1) {
+		return -1;
+	}
+	if(!(ctx = glXCreateNewContext(dpy, pbuf_fbconf, GLX_RGBA_TYPE, 0, True))) {
+		fprintf(stderr, "host: failed to create OpenGL context\n");
+		return -1;
+	}
+	glXMakeContextCurrent(dpy, pbuf, pbuf, ctx);
+	init_opengl();
+	return 0;
+}
+
 #ifdef HAVE_XRANDR
 static void detect_outputs(void)
 {
@@ -460,16 +811,37 @@ static int proc_xevent(XEvent *ev)
 {
 	KeySym sym;
 
+	if(cover_xevent(ev) || power_xevent(ev)) {
+		return 0;
+	}
+
 	switch(ev->type) {
 	case MapNotify:
-		mapped = 1;
+		if(ev->xmap.window == win) {
+			mapped = 1;
+		}
 		break;
 
 	case UnmapNotify:
-		mapped = 0;
+		if(ev->xunmap.window == win) {
+			mapped = 0;
+		}
+		break;
+
+	case VisibilityNotify:
+		if(ev->xvisibility.window == win) {
+			obscured = ev->xvisibility.state == VisibilityFullyObscured;
+		}
+		break;
+
+	case Expose:
+		if(ev->xexpose.window == win) {
+			damage_invalidate();
+		}
 		break;
 
 	case ConfigureNotify:
+		if(ev->xconfigure.window != win) break;
 		if(ev->xconfigure.width != win_width || ev->xconfigure.height != win_height) {
 			win_width = ev->xconfigure.width;
 			win_height = ev->xconfigure.height;
@@ -499,6 +871,8 @@ static int proc_xevent(XEvent *ev)
 				printf("Video outputs changed, reconfiguring\n");
 				XRRUpdateConfiguration(ev);
 				detect_outputs();
+				cover_update();
+				rscale_update();
 			}
 		}
 #endif
@@ -565,6 +939,34 @@ static int parse_args(int argc, char **argv)
 				new_win_parent = (Window)val;
 			}
 
+		} else if(strcmp(argv[i], "-time") == 0) {
+			if(!argv[++i]) {
+				fprintf(stderr, "-time must be followed by a time source\n");
+				return -1;
+			}
+			if(timesrc_set(argv[i]) == -1) {
+				return -1;
+			}
+
+		} else if(strcmp(argv[i], "-bench") == 0) {
+			if(!argv[i + 1] || !argv[i + 2]) {
+				fprintf(stderr, "-bench must be followed by a plugin name and a frame count\n");
+				return -1;
+			}
+			opt_bench = argv[++i];
+			val = strtol(argv[++i], &endp, 10);
+			if(endp == argv[i] || val <= 0) {
+				fprintf(stderr, "-bench: invalid frame count: %s\n", argv[i]);
+				return -1;
+			}
+			opt_bench_frames = val;
+
+		} else if(strcmp(argv[i], "-bake") == 0) {
+			opt_bake = 1;
+
+		} else if(strcmp(argv[i], "-sw") == 0) {
+			sw_render = 1;
+
 		} else if(strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "-help") == 0) {
 			print_usage(argv[0]);
 			exit(0);
@@ -587,5 +989,13 @@ static void print_usage(const char *argv0)
 	printf("  -r, -root: draw on the root window (default)\n");
 	printf("  -w <id>, -window <id>: draw on specified window\n");
 	printf("  -p, -preview: show preview on a new window\n");
+	printf("  -time <src>: animation time source: real (default), fixed[:<usec>],\n");
+	printf("        or scale:<factor>\n");
+	printf("  -bench <plugin> <frames>: draw frames offscreen as fast as possible,\n");
+	printf("        and print timing statistics\n");
+	printf("  -bake: draw a single frame, leave it as the root window background,\n");
+	printf("        and exit\n");
+	printf("  -sw: draw with the software renderer instead of OpenGL (only for plugins\n");
+	printf("        which support it)\n");
 	printf("  -h, -help: print usage information and exit\n");
 }
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "opengl.h"
 #include <GL/glx.h>
 
@@ -7,6 +8,41 @@
 
 GLUSEPROGRAMFUNC xlivebg_gl_use_program;
 GLBINDBUFFERFUNC xlivebg_gl_bind_buffer;
+GLBINDFRAMEBUFFERFUNC xlivebg_gl_bind_framebuffer;
+GLBINDVERTEXARRAYFUNC xlivebg_gl_bind_vertex_array;
+GLACTIVETEXTUREFUNC xlivebg_gl_active_texture;
+
+int gl_have_timer_query;
+GLGENQUERIESFUNC xlivebg_gl_gen_queries;
+GLDELETEQUERIESFUNC xlivebg_gl_delete_queries;
+GLBEGINQUERYFUNC xlivebg_gl_begin_query;
+GLENDQUERYFUNC xlivebg_gl_end_query;
+GLGETQUERYOBJECTIVFUNC xlivebg_gl_get_query_objectiv;
+GLGETQUERYOBJECTUI64VFUNC xlivebg_gl_get_query_objectui64v;
+
+int gl_have_pbo;
+GLGENBUFFERSFUNC xlivebg_gl_gen_buffers;
+GLDELETEBUFFERSFUNC xlivebg_gl_delete_buffers;
+GLBUFFERDATAFUNC xlivebg_gl_buffer_data;
+GLMAPBUFFERFUNC xlivebg_gl_map_buffer;
+GLUNMAPBUFFERFUNC xlivebg_gl_unmap_buffer;
+
+int gl_have_fbo;
+GLGENFRAMEBUFFERSFUNC xlivebg_gl_gen_framebuffers;
+GLDELETEFRAMEBUFFERSFUNC xlivebg_gl_delete_framebuffers;
+GLFRAMEBUFFERTEXTURE2DFUNC xlivebg_gl_framebuffer_texture_2d;
+GLCHECKFRAMEBUFFERSTATUSFUNC xlivebg_gl_check_framebuffer_status;
+
+int gl_have_fbo_blit;
+GLBLITFRAMEBUFFERFUNC xlivebg_gl_blit_framebuffer;
+
+int gl_have_s3tc;
+
+static int have_extension(const char *name);
+static void init_timer_query(void);
+static void init_pbo(void);
+static void init_fbo(void);
+static void reset_matrix(unsigned int mode, unsigned int depth_query);
 
 int init_opengl(void)
 {
@@ -16,9 +52,207 @@ int init_opengl(void)
 	if(!(xlivebg_gl_bind_buffer = (GLBINDBUFFERFUNC)GETGLFUNC("glBindBuffer"))) {
 		xlivebg_gl_bind_buffer = (GLBINDBUFFERFUNC)GETGLFUNC("glBindBufferARB");
 	}
+	if(!(xlivebg_gl_bind_framebuffer = (GLBINDFRAMEBUFFERFUNC)GETGLFUNC("glBindFramebuffer"))) {
+		xlivebg_gl_bind_framebuffer = (GLBINDFRAMEBUFFERFUNC)GETGLFUNC("glBindFramebufferEXT");
+	}
+	xlivebg_gl_bind_vertex_array = (GLBINDVERTEXARRAYFUNC)GETGLFUNC("glBindVertexArray");
+	if(!(xlivebg_gl_active_texture = (GLACTIVETEXTUREFUNC)GETGLFUNC("glActiveTexture"))) {
+		xlivebg_gl_active_texture = (GLACTIVETEXTUREFUNC)GETGLFUNC("glActiveTextureARB");
+	}
+	init_timer_query();
+	init_pbo();
+	init_fbo();
+	gl_have_s3tc = have_extension("GL_EXT_texture_compression_s3tc");
+	return 0;
+}
+
+void gl_reset_state(int width, int height)
+{
+	int i, depth, num_units = 1;
+
+	/* unwind anything left on the attribute stacks */
+	glGetIntegerv(GL_ATTRIB_STACK_DEPTH, &depth);
+	while(depth-- > 0) glPopAttrib();
+	glGetIntegerv(GL_CLIENT_ATTRIB_STACK_DEPTH, &depth);
+	while(depth-- > 0) glPopClientAttrib();
+
+	if(xlivebg_gl_use_program) xlivebg_gl_use_program(0);
+	if(xlivebg_gl_bind_buffer) {
+		xlivebg_gl_bind_buffer(GL_ARRAY_BUFFER, 0);
+		xlivebg_gl_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+	if(xlivebg_gl_bind_vertex_array) xlivebg_gl_bind_vertex_array(0);
+	if(xlivebg_gl_bind_framebuffer) xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+
+	if(xlivebg_gl_active_texture) {
+		glGetIntegerv(GL_MAX_TEXTURE_UNITS, &num_units);
+	}
+	for(i=num_units-1; i>=0; i--) {
+		if(xlivebg_gl_active_texture) {
+			xlivebg_gl_active_texture(GL_TEXTURE0 + i);
+		}
+		glBindTexture(GL_TEXTURE_1D, 0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glDisable(GL_TEXTURE_1D);
+		glDisable(GL_TEXTURE_2D);
+		glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+		reset_matrix(GL_TEXTURE, GL_TEXTURE_STACK_DEPTH);
+	}
+	reset_matrix(GL_PROJECTION, GL_PROJECTION_STACK_DEPTH);
+	reset_matrix(GL_MODELVIEW, GL_MODELVIEW_STACK_DEPTH);
+
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	glDisable(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_ALPHA_TEST);
+	glDisable(GL_STENCIL_TEST);
+	glDisable(GL_SCISSOR_TEST);
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_FOG);
+	glDisable(GL_COLOR_MATERIAL);
+
+	glBlendFunc(GL_ONE, GL_ZERO);
+	glAlphaFunc(GL_ALWAYS, 0.0f);
+	glDepthFunc(GL_LESS);
+	glDepthMask(1);
+	glColorMask(1, 1, 1, 1);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	glShadeModel(GL_SMOOTH);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glColor4f(1, 1, 1, 1);
+	glClearColor(0, 0, 0, 0);
+	glViewport(0, 0, width, height);
+}
+
+static void reset_matrix(unsigned int mode, unsigned int depth_query)
+{
+	int depth;
+
+	glMatrixMode(mode);
+	glGetIntegerv(depth_query, &depth);
+	while(depth-- > 1) glPopMatrix();
+	glLoadIdentity();
+}
+
+static int have_extension(const char *name)
+{
+	const char *ext, *ptr;
+	int len = strlen(name);
+
+	if(!(ext = (const char*)glGetString(GL_EXTENSIONS))) {
+		return 0;
+	}
+	ptr = ext;
+	while((ptr = strstr(ptr, name))) {
+		if((ptr == ext || ptr[-1] == ' ') && (ptr[len] == ' ' || ptr[len] == 0)) {
+			return 1;
+		}
+		ptr += len;
+	}
 	return 0;
 }
 
+static void init_timer_query(void)
+{
+	gl_have_timer_query = 0;
+
+	if(have_extension("GL_ARB_timer_query")) {
+		xlivebg_gl_get_query_objectui64v = (GLGETQUERYOBJECTUI64VFUNC)GETGLFUNC("glGetQueryObjectui64v");
+	} else if(have_extension("GL_EXT_timer_query")) {
+		xlivebg_gl_get_query_objectui64v = (GLGETQUERYOBJECTUI64VFUNC)GETGLFUNC("glGetQueryObjectui64vEXT");
+	} else {
+		return;
+	}
+
+	/* the rest are core since GL 1.5, or come with ARB_occlusion_query */
+	if(!(xlivebg_gl_gen_queries = (GLGENQUERIESFUNC)GETGLFUNC("glGenQueries"))) {
+		xlivebg_gl_gen_queries = (GLGENQUERIESFUNC)GETGLFUNC("glGenQueriesARB");
+	}
+	if(!(xlivebg_gl_delete_queries = (GLDELETEQUERIESFUNC)GETGLFUNC("glDeleteQueries"))) {
+		xlivebg_gl_delete_queries = (GLDELETEQUERIESFUNC)GETGLFUNC("glDeleteQueriesARB");
+	}
+	if(!(xlivebg_gl_begin_query = (GLBEGINQUERYFUNC)GETGLFUNC("glBeginQuery"))) {
+		xlivebg_gl_begin_query = (GLBEGINQUERYFUNC)GETGLFUNC("glBeginQueryARB");
+	}
+	if(!(xlivebg_gl_end_query = (GLENDQUERYFUNC)GETGLFUNC("glEndQuery"))) {
+		xlivebg_gl_end_query = (GLENDQUERYFUNC)GETGLFUNC("glEndQueryARB");
+	}
+	if(!(xlivebg_gl_get_query_objectiv = (GLGETQUERYOBJECTIVFUNC)GETGLFUNC("glGetQueryObjectiv"))) {
+		xlivebg_gl_get_query_objectiv = (GLGETQUERYOBJECTIVFUNC)GETGLFUNC("glGetQueryObjectivARB");
+	}
+
+	gl_have_timer_query = xlivebg_gl_gen_queries && xlivebg_gl_delete_queries &&
+		xlivebg_gl_begin_query && xlivebg_gl_end_query && xlivebg_gl_get_query_objectiv &&
+		xlivebg_gl_get_query_objectui64v;
+}
+
+static void init_pbo(void)
+{
+	gl_have_pbo = 0;
+
+	if(!have_extension("GL_ARB_pixel_buffer_object") && !have_extension("GL_EXT_pixel_buffer_object")) {
+		return;
+	}
+
+	/* buffer objects are core since GL 1.5, or come with ARB_vertex_buffer_object */
+	if(!(xlivebg_gl_gen_buffers = (GLGENBUFFERSFUNC)GETGLFUNC("glGenBuffers"))) {
+		xlivebg_gl_gen_buffers = (GLGENBUFFERSFUNC)GETGLFUNC("glGenBuffersARB");
+	}
+	if(!(xlivebg_gl_delete_buffers = (GLDELETEBUFFERSFUNC)GETGLFUNC("glDeleteBuffers"))) {
+		xlivebg_gl_delete_buffers = (GLDELETEBUFFERSFUNC)GETGLFUNC("glDeleteBuffersARB");
+	}
+	if(!(xlivebg_gl_buffer_data = (GLBUFFERDATAFUNC)GETGLFUNC("glBufferData"))) {
+		xlivebg_gl_buffer_data = (GLBUFFERDATAFUNC)GETGLFUNC("glBufferDataARB");
+	}
+	if(!(xlivebg_gl_map_buffer = (GLMAPBUFFERFUNC)GETGLFUNC("glMapBuffer"))) {
+		xlivebg_gl_map_buffer = (GLMAPBUFFERFUNC)GETGLFUNC("glMapBufferARB");
+	}
+	if(!(xlivebg_gl_unmap_buffer = (GLUNMAPBUFFERFUNC)GETGLFUNC("glUnmapBuffer"))) {
+		xlivebg_gl_unmap_buffer = (GLUNMAPBUFFERFUNC)GETGLFUNC("glUnmapBufferARB");
+	}
+
+	gl_have_pbo = xlivebg_gl_bind_buffer && xlivebg_gl_gen_buffers && xlivebg_gl_delete_buffers &&
+		xlivebg_gl_buffer_data && xlivebg_gl_map_buffer && xlivebg_gl_unmap_buffer;
+}
+
+static void init_fbo(void)
+{
+	/* core since GL 3.0, or come with ARB_framebuffer_object or EXT_framebuffer_object */
+	if(!(xlivebg_gl_gen_framebuffers = (GLGENFRAMEBUFFERSFUNC)GETGLFUNC("glGenFramebuffers"))) {
+		xlivebg_gl_gen_framebuffers = (GLGENFRAMEBUFFERSFUNC)GETGLFUNC("glGenFramebuffersEXT");
+	}
+	if(!(xlivebg_gl_delete_framebuffers = (GLDELETEFRAMEBUFFERSFUNC)GETGLFUNC("glDeleteFramebuffers"))) {
+		xlivebg_gl_delete_framebuffers = (GLDELETEFRAMEBUFFERSFUNC)GETGLFUNC("glDeleteFramebuffersEXT");
+	}
+	if(!(xlivebg_gl_framebuffer_texture_2d = (GLFRAMEBUFFERTEXTURE2DFUNC)GETGLFUNC("glFramebufferTexture2D"))) {
+		xlivebg_gl_framebuffer_texture_2d = (GLFRAMEBUFFERTEXTURE2DFUNC)GETGLFUNC("glFramebufferTexture2DEXT");
+	}
+	if(!(xlivebg_gl_check_framebuffer_status = (GLCHECKFRAMEBUFFERSTATUSFUNC)GETGLFUNC("glCheckFramebufferStatus"))) {
+		xlivebg_gl_check_framebuffer_status = (GLCHECKFRAMEBUFFERSTATUSFUNC)GETGLFUNC("glCheckFramebufferStatusEXT");
+	}
+
+	gl_have_fbo = (have_extension("GL_ARB_framebuffer_object") || have_extension("GL_EXT_framebuffer_object")) &&
+		xlivebg_gl_bind_framebuffer && xlivebg_gl_gen_framebuffers && xlivebg_gl_delete_framebuffers &&
+		xlivebg_gl_framebuffer_texture_2d && xlivebg_gl_check_framebuffer_status;
+
+	gl_have_fbo_blit = 0;
+	if(gl_have_fbo) {
+		if(have_extension("GL_ARB_framebuffer_object")) {
+			xlivebg_gl_blit_framebuffer = (GLBLITFRAMEBUFFERFUNC)GETGLFUNC("glBlitFramebuffer");
+		} else if(have_extension("GL_EXT_framebuffer_blit")) {
+			xlivebg_gl_blit_framebuffer = (GLBLITFRAMEBUFFERFUNC)GETGLFUNC("glBlitFramebufferEXT");
+		}
+		gl_have_fbo_blit = xlivebg_gl_blit_framebuffer != 0;
+	}
+}
+
 void dump_texture(unsigned int tex, const char *fname)
 {
 	FILE *fp;
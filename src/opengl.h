@@ -1,6 +1,7 @@
 #ifndef OPENGL_H_
 #define OPENGL_H_
 
+#include <inttypes.h>
 #include <GL/gl.h>
 
 #ifndef GL_CURRENT_PROGRAM
@@ -9,15 +10,132 @@
 #ifndef GL_ARRAY_BUFFER
 #define GL_ARRAY_BUFFER 0x8892
 #endif
+#ifndef GL_ELEMENT_ARRAY_BUFFER
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#endif
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER 0x8d40
+#endif
+#ifndef GL_TEXTURE0
+#define GL_TEXTURE0 0x84c0
+#endif
+#ifndef GL_MAX_TEXTURE_UNITS
+#define GL_MAX_TEXTURE_UNITS 0x84e2
+#endif
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88bf
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88eb
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88e1
+#endif
+#ifndef GL_READ_ONLY
+#define GL_READ_ONLY 0x88b8
+#endif
+#ifndef GL_FRAMEBUFFER_BINDING
+#define GL_FRAMEBUFFER_BINDING 0x8ca6
+#endif
+#ifndef GL_BGRA
+#define GL_BGRA 0x80e1
+#endif
+#ifndef GL_COLOR_ATTACHMENT0
+#define GL_COLOR_ATTACHMENT0 0x8ce0
+#endif
+#ifndef GL_FRAMEBUFFER_COMPLETE
+#define GL_FRAMEBUFFER_COMPLETE 0x8cd5
+#endif
+#ifndef GL_READ_FRAMEBUFFER
+#define GL_READ_FRAMEBUFFER 0x8ca8
+#endif
+#ifndef GL_DRAW_FRAMEBUFFER
+#define GL_DRAW_FRAMEBUFFER 0x8ca9
+#endif
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83f0
+#endif
+#ifndef GL_READ_FRAMEBUFFER_BINDING
+#define GL_READ_FRAMEBUFFER_BINDING 0x8caa
+#endif
+#ifndef GL_DRAW_FRAMEBUFFER_BINDING
+#define GL_DRAW_FRAMEBUFFER_BINDING 0x8ca6
+#endif
 
 typedef void (*GLUSEPROGRAMFUNC)(unsigned int);
 typedef void (*GLBINDBUFFERFUNC)(unsigned int, unsigned int);
+typedef void (*GLBINDFRAMEBUFFERFUNC)(unsigned int, unsigned int);
+typedef void (*GLBINDVERTEXARRAYFUNC)(unsigned int);
+typedef void (*GLACTIVETEXTUREFUNC)(unsigned int);
+typedef void (*GLGENQUERIESFUNC)(int, unsigned int*);
+typedef void (*GLDELETEQUERIESFUNC)(int, const unsigned int*);
+typedef void (*GLBEGINQUERYFUNC)(unsigned int, unsigned int);
+typedef void (*GLENDQUERYFUNC)(unsigned int);
+typedef void (*GLGETQUERYOBJECTIVFUNC)(unsigned int, unsigned int, int*);
+typedef void (*GLGETQUERYOBJECTUI64VFUNC)(unsigned int, unsigned int, uint64_t*);
+typedef void (*GLGENBUFFERSFUNC)(int, unsigned int*);
+typedef void (*GLDELETEBUFFERSFUNC)(int, const unsigned int*);
+typedef void (*GLBUFFERDATAFUNC)(unsigned int, long, const void*, unsigned int);
+typedef void *(*GLMAPBUFFERFUNC)(unsigned int, unsigned int);
+typedef unsigned char (*GLUNMAPBUFFERFUNC)(unsigned int);
+typedef void (*GLGENFRAMEBUFFERSFUNC)(int, unsigned int*);
+typedef void (*GLDELETEFRAMEBUFFERSFUNC)(int, const unsigned int*);
+typedef void (*GLFRAMEBUFFERTEXTURE2DFUNC)(unsigned int, unsigned int, unsigned int, unsigned int, int);
+typedef unsigned int (*GLCHECKFRAMEBUFFERSTATUSFUNC)(unsigned int);
+typedef void (*GLBLITFRAMEBUFFERFUNC)(int, int, int, int, int, int, int, int, unsigned int, unsigned int);
 
 extern GLUSEPROGRAMFUNC xlivebg_gl_use_program;
 extern GLBINDBUFFERFUNC xlivebg_gl_bind_buffer;
+extern GLBINDFRAMEBUFFERFUNC xlivebg_gl_bind_framebuffer;
+extern GLBINDVERTEXARRAYFUNC xlivebg_gl_bind_vertex_array;
+extern GLACTIVETEXTUREFUNC xlivebg_gl_active_texture;
+
+/* timer queries (GL_TIME_ELAPSED), only valid if gl_have_timer_query is set */
+extern int gl_have_timer_query;
+extern GLGENQUERIESFUNC xlivebg_gl_gen_queries;
+extern GLDELETEQUERIESFUNC xlivebg_gl_delete_queries;
+extern GLBEGINQUERYFUNC xlivebg_gl_begin_query;
+extern GLENDQUERYFUNC xlivebg_gl_end_query;
+extern GLGETQUERYOBJECTIVFUNC xlivebg_gl_get_query_objectiv;
+extern GLGETQUERYOBJECTUI64VFUNC xlivebg_gl_get_query_objectui64v;
+
+/* pixel buffer objects (GL_PIXEL_PACK_BUFFER), only valid if gl_have_pbo is set */
+extern int gl_have_pbo;
+extern GLGENBUFFERSFUNC xlivebg_gl_gen_buffers;
+extern GLDELETEBUFFERSFUNC xlivebg_gl_delete_buffers;
+extern GLBUFFERDATAFUNC xlivebg_gl_buffer_data;
+extern GLMAPBUFFERFUNC xlivebg_gl_map_buffer;
+extern GLUNMAPBUFFERFUNC xlivebg_gl_unmap_buffer;
+
+/* framebuffer objects, only valid if gl_have_fbo is set */
+extern int gl_have_fbo;
+extern GLGENFRAMEBUFFERSFUNC xlivebg_gl_gen_framebuffers;
+extern GLDELETEFRAMEBUFFERSFUNC xlivebg_gl_delete_framebuffers;
+extern GLFRAMEBUFFERTEXTURE2DFUNC xlivebg_gl_framebuffer_texture_2d;
+extern GLCHECKFRAMEBUFFERSTATUSFUNC xlivebg_gl_check_framebuffer_status;
+
+/* framebuffer blits, and separate read/draw framebuffer bindings, only valid
+ * if gl_have_fbo_blit is set.
+ */
+extern int gl_have_fbo_blit;
+extern GLBLITFRAMEBUFFERFUNC xlivebg_gl_blit_framebuffer;
+
+/* DXT1 compressed textures (GL_EXT_texture_compression_s3tc) */
+extern int gl_have_s3tc;
 
 int init_opengl(void);
 
+/* brings the OpenGL state back to a known baseline, undoing whatever the
+ * previously active plugin left behind: stacks, bindings, enables, etc.
+ */
+void gl_reset_state(int width, int height);
+
 void dump_texture(unsigned int tex, const char *fname);
 
 #endif	/* OPENGL_H_ */
@@ -17,8 +17,10 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
 #ifdef HAVE_ALLOCA_H
 #include <alloca.h>
 #endif
@@ -26,25 +28,89 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <dirent.h>
 #include <dlfcn.h>
 #include <sys/stat.h>
+#include <sys/types.h>
+#ifdef HAVE_INOTIFY
+#include <sys/inotify.h>
+#endif
 #include "opengl.h"
 #include "xlivebg.h"
 #include "app.h"
 #include "imageman.h"
 #include "util.h"
 #include "cfg.h"
+#include "evloop.h"
+#include "gltrack.h"
+#include "sched.h"
+#include "damage.h"
+#include "quality.h"
+#include "swrender.h"
+#include "host.h"
+#include "layer.h"
+#include "bgcache.h"
+#include "rscale.h"
+#include "still.h"
+#include "loopcache.h"
 #include "treestore.h"
 
+/* size of the original xlivebg_plugin structure, up to and including so */
+#define PLUGIN_SIZE_V1	((int)offsetof(struct xlivebg_plugin, suspend))
+
 static int load_plugins(const char *dirpath);
+static int load_plugin_file(const char *fname, struct stat *st);
 static void update_cfg(const char *cfgpath, struct ts_value *tsval);
 static const char *get_builtin_str(const char *cfgpath);
 static float *get_builtin_num(const char *cfgpath);
 static int *get_builtin_int(const char *cfgpath);
 static float *get_builtin_vec(const char *cfgpath);
+static void stop_plugin(struct xlivebg_plugin *plugin);
+static int has_prop(struct xlivebg_plugin *plugin, const char *aname);
+static int called_by_layer(void);
+static void update_layer_cfg(const char *cfgpath);
+static int is_bg_cfg(const char *cfgpath);
+static struct plugin_rec *find_rec(struct xlivebg_plugin *plugin);
+static int load_plugin_so(struct plugin_rec *rec);
+static void free_stub(struct xlivebg_plugin *stub);
+#ifdef HAVE_INOTIFY
+static void watch_plugin_dir(const char *dirpath);
+static void close_plugin_watch(void);
+#endif
+
+/* core-private per-plugin state */
+struct plugin_rec {
+	struct xlivebg_plugin *plugin;
+	int init_done;
+	int layer;			/* running as a layer on top of the active plugin */
+	int64_t stop_time;	/* when it was last deactivated, for the delayed cleanup */
+	int quality_level;	/* adaptive quality level it last ran at, -1 if never */
+
+	char *path;		/* shared object this plugin came from */
+	/* plugins built against an older, smaller xlivebg_plugin structure are
+	 * copied here by xlivebg_register_plugin2, and plugin points to it.
+	 */
+	struct xlivebg_plugin *copy;
+	/* registered from the manifest cache, without loading the shared object.
+	 * If non-null it's the same as plugin, until the first activation.
+	 */
+	struct xlivebg_plugin *stub;
+};
 
 static struct xlivebg_plugin *act;
-static struct xlivebg_plugin **plugins;
+static struct xlivebg_plugin *starting_layer;
+static int gl_ready;
+static struct plugin_rec *plugins;
 static int num_plugins, max_plugins;
 
+/* while non-null, plugins registered are loaded on behalf of this stub */
+static struct plugin_rec *loading;
+
+/* manifest cache: registration metadata of every plugin shared object found
+ * during the last scan, keyed by path, modification time and size. Plugins
+ * with a valid entry are listed without dlopen-ing them, and only loaded when
+ * activated.
+ */
+static struct ts_node *cache, *newcache;
+static int cache_dirty;
+
 /* searches for, and loads, all available plugins.
  * search paths:
  *  - PREFIX/lib/xlivebg/
@@ -55,7 +121,20 @@ void init_plugins(void)
 {
 	DIR *dir;
 	char *home = get_home_dir();
-	char *dirpath;
+	char *dirpath, *cachepath;
+
+	cachepath = alloca(strlen(home) + 32);
+	sprintf(cachepath, "%s/.xlivebg/plugins.cache", home);
+
+	if(access(cachepath, R_OK) == 0 && (cache = ts_load(cachepath)) && strcmp(cache->name, "plugincache") != 0) {
+		ts_free_tree(cache);
+		cache = 0;
+	}
+	if(!(newcache = ts_alloc_node()) || !(newcache->name = strdup("plugincache"))) {
+		ts_free_node(newcache);
+		newcache = 0;
+	}
+	cache_dirty = 0;
 
 #ifndef NDEBUG
 	/* special-case: during development, it helps if I can just load plugins from
@@ -80,6 +159,198 @@ void init_plugins(void)
 
 	sprintf(dirpath, "%s/.xlivebg/plugins", home);
 	load_plugins(dirpath);
+
+	/* entries left over in the old cache are for files which no longer exist */
+	if(cache && cache->child_count > 0) {
+		cache_dirty = 1;
+	}
+	if(newcache && cache_dirty) {
+		sprintf(dirpath, "%s/.xlivebg", home);
+		mkdir(dirpath, 0755);
+		if(ts_save(newcache, cachepath) == -1) {
+			fprintf(stderr, "xlivebg: failed to write plugin cache: %s\n", cachepath);
+		}
+	}
+	ts_free_tree(cache);
+	ts_free_tree(newcache);
+	cache = newcache = 0;
+}
+
+/* treestore strings can't contain double quotes, so they're stored %-encoded */
+static char *cache_escape(const char *str)
+{
+	char *res, *dest;
+
+	if(!(res = malloc(strlen(str) * 3 + 1))) {
+		return 0;
+	}
+	dest = res;
+	while(*str) {
+		if(*str == '"' || *str == '%') {
+			dest += sprintf(dest, "%%%02x", (unsigned int)*str);
+		} else {
+			*dest++ = *str;
+		}
+		str++;
+	}
+	*dest = 0;
+	return res;
+}
+
+static char *cache_unescape(const char *str)
+{
+	char *res, *dest;
+	unsigned int c;
+
+	if(!(res = malloc(strlen(str) + 1))) {
+		return 0;
+	}
+	dest = res;
+	while(*str) {
+		if(str[0] == '%' && isxdigit(str[1]) && isxdigit(str[2]) && sscanf(str + 1, "%2x", &c) == 1) {
+			*dest++ = c;
+			str += 3;
+		} else {
+			*dest++ = *str++;
+		}
+	}
+	*dest = 0;
+	return res;
+}
+
+static int cache_add_attr(struct ts_node *node, const char *name, const char *val)
+{
+	struct ts_attr *attr;
+	char *esc;
+
+	if(!(esc = cache_escape(val))) {
+		return -1;
+	}
+	if(!(attr = ts_alloc_attr()) || ts_set_attr_name(attr, name) == -1 ||
+			ts_set_value_str(&attr->val, esc) == -1) {
+		ts_free_attr(attr);
+		free(esc);
+		return -1;
+	}
+	free(esc);
+	ts_add_attr(node, attr);
+	return 0;
+}
+
+/* finds a cache entry for this file, matching its modification time and size,
+ * and moves it over to the new cache.
+ */
+static struct ts_node *cache_lookup(const char *fname, struct stat *st)
+{
+	struct ts_node *node;
+	char buf[32];
+
+	if(!cache || !newcache) return 0;
+
+	node = cache->child_list;
+	while(node) {
+		if(strcmp(node->name, "plugin") == 0 &&
+				strcmp(ts_get_attr_str(node, "path", ""), fname) == 0) {
+			ts_remove_child(cache, node);
+
+			sprintf(buf, "%ld", (long)st->st_mtime);
+			if(strcmp(ts_get_attr_str(node, "mtime", ""), buf) != 0) {
+				ts_free_tree(node);
+				return 0;
+			}
+			sprintf(buf, "%ld", (long)st->st_size);
+			if(strcmp(ts_get_attr_str(node, "size", ""), buf) != 0) {
+				ts_free_tree(node);
+				return 0;
+			}
+
+			ts_add_child(newcache, node);
+			return node;
+		}
+		node = node->next;
+	}
+	return 0;
+}
+
+/* records what a shared object registered (if anything) in the new cache */
+static void cache_add(const char *fname, struct stat *st, struct xlivebg_plugin *plugin)
+{
+	struct ts_node *node;
+	char buf[32];
+	int res = 0;
+
+	if(!newcache) return;
+
+	if(!(node = ts_alloc_node()) || !(node->name = strdup("plugin"))) {
+		ts_free_node(node);
+		return;
+	}
+	res |= cache_add_attr(node, "path", fname);
+	sprintf(buf, "%ld", (long)st->st_mtime);
+	res |= cache_add_attr(node, "mtime", buf);
+	sprintf(buf, "%ld", (long)st->st_size);
+	res |= cache_add_attr(node, "size", buf);
+
+	if(plugin) {
+		res |= cache_add_attr(node, "name", plugin->name);
+		if(plugin->desc) {
+			res |= cache_add_attr(node, "desc", plugin->desc);
+		}
+		if(plugin->props) {
+			res |= cache_add_attr(node, "props", plugin->props);
+		}
+		sprintf(buf, "%ld", plugin->upd_interval);
+		res |= cache_add_attr(node, "upd_interval", buf);
+	}
+
+	if(res) {
+		ts_free_tree(node);
+		return;
+	}
+	ts_add_child(newcache, node);
+	cache_dirty = 1;
+}
+
+/* registers a stub plugin from a cache entry. Entries without a name are
+ * shared objects which didn't register anything, and are skipped.
+ */
+static int register_cached(const char *fname, struct ts_node *node)
+{
+	struct xlivebg_plugin *stub;
+	const char *str;
+
+	if(!(str = ts_get_attr_str(node, "name", 0))) {
+		return 0;
+	}
+
+	if(!(stub = calloc(1, sizeof *stub)) || !(stub->name = cache_unescape(str))) {
+		free(stub);
+		return -1;
+	}
+	if((str = ts_get_attr_str(node, "desc", 0))) {
+		stub->desc = cache_unescape(str);
+	}
+	if((str = ts_get_attr_str(node, "props", 0))) {
+		stub->props = cache_unescape(str);
+	}
+	stub->upd_interval = atol(ts_get_attr_str(node, "upd_interval", "0"));
+
+	if(xlivebg_register_plugin2(stub, sizeof *stub) == -1) {
+		free_stub(stub);
+		return -1;
+	}
+	plugins[num_plugins - 1].path = strdup(fname);
+	plugins[num_plugins - 1].stub = stub;
+	return 1;
+}
+
+static void free_stub(struct xlivebg_plugin *stub)
+{
+	if(!stub) return;
+	free(stub->name);
+	free(stub->desc);
+	free(stub->props);
+	free(stub);
 }
 
 static int load_plugins(const char *dirpath)
@@ -89,8 +360,6 @@ static int load_plugins(const char *dirpath)
 	struct dirent *dent;
 	struct stat st;
 	char fname[1024];
-	void *so;
-	int (*reg)(void);
 
 	if(!(dir = opendir(dirpath))) {
 		return -1;
@@ -105,134 +374,729 @@ static int load_plugins(const char *dirpath)
 		if(stat(fname, &st) == -1 || !S_ISREG(st.st_mode)) {
 			continue;
 		}
+		if(load_plugin_file(fname, &st) > 0) {
+			num++;
+		}
+	}
+	closedir(dir);
 
-		if((so = dlopen(fname, RTLD_LAZY))) {
-			if((reg = dlsym(so, "register_plugin")) && reg() != -1) {
-				plugins[num_plugins - 1]->so = so;
-				num++;
-			} else {
-				dlclose(so);
+#ifdef HAVE_INOTIFY
+	watch_plugin_dir(dirpath);
+#endif
+	return num;
+}
+
+/* returns 1 if the file registered a plugin, 0 if not, -1 on error */
+static int load_plugin_file(const char *fname, struct stat *st)
+{
+	void *so;
+	int (*reg)(void);
+	struct ts_node *ent;
+
+	if((ent = cache_lookup(fname, st))) {
+		return register_cached(fname, ent);
+	}
+
+	if(!(so = dlopen(fname, RTLD_LAZY))) {
+		fprintf(stderr, "failed to open plugin: %s: %s\n", fname, dlerror());
+		return -1;
+	}
+
+	if((reg = dlsym(so, "register_plugin")) && reg() != -1) {
+		plugins[num_plugins - 1].plugin->so = so;
+		plugins[num_plugins - 1].path = strdup(fname);
+		cache_add(fname, st, plugins[num_plugins - 1].plugin);
+		return 1;
+	}
+
+	/* only remember shared objects which aren't plugins at all. Failing
+	 * to register might be due to a name clash, which could go away.
+	 */
+	if(!reg) cache_add(fname, st, 0);
+	dlclose(so);
+	return 0;
+}
+
+struct xlivebg_plugin *get_plugin(int idx)
+{
+	return plugins[idx].plugin;
+}
+
+int get_plugin_count(void)
+{
+	return num_plugins;
+}
+
+struct xlivebg_plugin *find_plugin(const char *name)
+{
+	int i;
+
+	for(i=0; i<num_plugins; i++) {
+		if(strcasecmp(name, plugins[i].plugin->name) == 0) {
+			return plugins[i].plugin;
+		}
+	}
+	return 0;
+}
+
+int activate_plugin(struct xlivebg_plugin *plugin)
+{
+	struct xlivebg_plugin *prev = act;
+	struct plugin_rec *rec = find_rec(plugin);
+	void *owner;
+	int isolate, res;
+
+	printf("xlivebg: activating plugin: %s\n", plugin->name);
+
+	/* plugins registered from the manifest cache are loaded on first activation */
+	if(rec->stub) {
+		if(load_plugin_so(rec) == -1) {
+			return -1;
+		}
+		plugin = rec->plugin;
+	}
+
+	/* the OpenGL context (or the software framebuffer) is created once, and
+	 * kept across plugin switches.
+	 */
+	if(!gl_ready) {
+		if(xlivebg_init_gl() == -1) {
+			fprintf(stderr, "xlivebg: failed to initialize OpenGL\n");
+			return -1;
+		}
+		gl_ready = 1;
+	}
+	if(sw_render && !plugin->draw_sw) {
+		fprintf(stderr, "xlivebg: plugin %s doesn't support software rendering\n", plugin->name);
+		return -1;
+	}
+
+	/* a plugin drawn as a layer becomes the bottom one */
+	if(rec->layer) {
+		layer_remove(plugin);
+	}
+
+	/* isolated plugins are initialized and started by their host process, and
+	 * never touched in this one.
+	 */
+	isolate = cfg.isolate;
+
+	/* plugins are initialized lazily, on first activation. Objects created
+	 * during init are kept until cleanup, instead of being released with
+	 * whichever plugin is stopped next.
+	 */
+	if(!isolate && !rec->init_done) {
+		owner = gltrack_owner(0);
+		res = plugin->init ? plugin->init(plugin->data) : 0;
+		gltrack_owner(owner);
+		if(res == -1) {
+			fprintf(stderr, "xlivebg: plugin %s failed to initialize\n", plugin->name);
+			return -1;
+		}
+		rec->init_done = 1;
+	}
+
+	if(act) {
+		stop_plugin(act);
+		act = 0;
+	}
+
+	/* drop any state left from an earlier in-process activation, the host
+	 * initializes its own. The plugin may be the one just stopped, when
+	 * re-activating it after turning isolation on.
+	 */
+	if(isolate && rec->init_done) {
+		if(plugin->cleanup) {
+			plugin->cleanup(plugin->data);
+		}
+		rec->init_done = 0;
+	}
+
+	gltrack_owner(plugin);
+	quality_activate(plugin, rec->quality_level);
+	still_reset();
+	loopcache_reset();
+	if(isolate) {
+		res = host_start(plugin);
+	} else {
+		res = plugin->start ? plugin->start(msec, plugin->data) : 0;
+	}
+	if(res == -1) {
+		fprintf(stderr, "xlivebg: plugin %s failed to start\n", plugin->name);
+		if(prev && prev != plugin) {
+			stop_plugin(plugin);
+			activate_plugin(prev);
+			return -1;
+		}
+	}
+	act = plugin;
+	damage_invalidate();
+
+	upd_interval_usec = act->upd_interval;
+
+	free(cfg.act_plugin);
+	cfg.act_plugin = strdup(plugin->name);
+
+	layer_setup();
+	return 0;
+}
+
+struct xlivebg_plugin *start_layer_plugin(struct xlivebg_plugin *plugin)
+{
+	struct plugin_rec *rec = find_rec(plugin);
+	void *owner;
+	int res = 0;
+
+	if(rec->stub) {
+		if(load_plugin_so(rec) == -1) {
+			return 0;
+		}
+		plugin = rec->plugin;
+	}
+
+	/* objects created during init are kept until cleanup, those created
+	 * after start are released when the layer is stopped.
+	 */
+	owner = gltrack_owner(0);
+	if(!rec->init_done) {
+		if(plugin->init && plugin->init(plugin->data) == -1) {
+			fprintf(stderr, "xlivebg: plugin %s failed to initialize\n", plugin->name);
+			gltrack_owner(owner);
+			return 0;
+		}
+		rec->init_done = 1;
+	}
+
+	gltrack_owner(plugin);
+	starting_layer = plugin;
+	if(plugin->start && plugin->start(msec, plugin->data) == -1) {
+		fprintf(stderr, "xlivebg: plugin %s failed to start\n", plugin->name);
+		gltrack_release(plugin);
+		res = -1;
+	}
+	starting_layer = 0;
+	gltrack_owner(owner);
+
+	if(res == -1) {
+		return 0;
+	}
+	rec->layer = 1;
+	return plugin;
+}
+
+void stop_layer_plugin(struct xlivebg_plugin *plugin)
+{
+	struct plugin_rec *rec = find_rec(plugin);
+	int count;
+
+	if(plugin->stop) {
+		plugin->stop(plugin->data);
+	}
+	rec->layer = 0;
+	rec->stop_time = sched_time_usec();
+
+	if((count = gltrack_release(plugin)) > 0) {
+		printf("xlivebg: freed %d OpenGL objects left behind by %s\n", count, plugin->name);
+	}
+}
+
+/* calls cleanup on plugins which have been inactive for longer than
+ * cleanup_after seconds, to release their memory until they're needed again.
+ */
+void cleanup_inactive_plugins(int64_t now)
+{
+	int i;
+	struct plugin_rec *rec;
+
+	if(cfg.cleanup_after <= 0) return;
+
+	for(i=0; i<num_plugins; i++) {
+		rec = plugins + i;
+		if(!rec->init_done || rec->plugin == act || rec->layer) continue;
+
+		if(now - rec->stop_time >= (int64_t)cfg.cleanup_after * 1000000) {
+			printf("xlivebg: cleaning up inactive plugin: %s\n", rec->plugin->name);
+			if(rec->plugin->cleanup) {
+				rec->plugin->cleanup(rec->plugin->data);
 			}
-		} else {
-			fprintf(stderr, "failed to open plugin: %s: %s\n", fname, dlerror());
+			rec->init_done = 0;
+		}
+	}
+}
+
+/* calls cleanup for all initialized plugins, before exiting */
+void cleanup_plugins(void)
+{
+	int i;
+
+#ifdef HAVE_INOTIFY
+	close_plugin_watch();
+#endif
+	host_stop();
+
+	for(i=0; i<num_plugins; i++) {
+		if(plugins[i].init_done && plugins[i].plugin->cleanup) {
+			plugins[i].plugin->cleanup(plugins[i].plugin->data);
+		}
+		plugins[i].init_done = 0;
+	}
+}
+
+/* stops a plugin, frees any GL objects it didn't free itself, and resets the
+ * GL state for the next one.
+ */
+static void stop_plugin(struct xlivebg_plugin *plugin)
+{
+	int count;
+	struct plugin_rec *rec;
+
+	if(host_active()) {
+		host_stop();
+	} else if(plugin->stop) {
+		plugin->stop(plugin->data);
+	}
+	rec = find_rec(plugin);
+	rec->stop_time = sched_time_usec();
+	rec->quality_level = quality_level();
+
+	if((count = gltrack_release(plugin)) > 0) {
+		printf("xlivebg: freed %d OpenGL objects left behind by %s\n", count, plugin->name);
+	}
+	gltrack_owner(0);
+	if(!sw_render) {
+		gl_reset_state(rscale_width(), rscale_height());
+	}
+}
+
+struct xlivebg_plugin *get_active_plugin(void)
+{
+	return act;
+}
+
+static struct plugin_rec *find_rec(struct xlivebg_plugin *plugin)
+{
+	int i;
+
+	for(i=0; i<num_plugins; i++) {
+		if(plugins[i].plugin == plugin) {
+			return plugins + i;
+		}
+	}
+	return 0;
+}
+
+/* returns non-zero if the plugin calling into the API is running as a layer.
+ * The plugin making the call is the one owning new GL objects.
+ */
+static int called_by_layer(void)
+{
+	struct plugin_rec *rec;
+	void *owner;
+
+	owner = gltrack_owner(0);
+	gltrack_owner(owner);
+
+	return starting_layer || (owner && (rec = find_rec(owner)) && rec->layer);
+}
+
+/* returns non-zero for the built-in options plugins get to see through the
+ * API: the background image, colors, and fit.
+ */
+static int is_bg_cfg(const char *cfgpath)
+{
+	static const char *names[] = {
+		CFGNAME_IMAGE, CFGNAME_ANIM_MASK, CFGNAME_COLOR, CFGNAME_COLOR2, CFGNAME_BGMODE,
+		CFGNAME_FIT, CFGNAME_CROP_ZOOM, CFGNAME_CROP_DIR, 0
+	};
+	int i;
+
+	for(i=0; names[i]; i++) {
+		if(strcmp(cfgpath, names[i]) == 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* loads the shared object of a plugin registered from the manifest cache, and
+ * replaces the stub with the real thing.
+ */
+static int load_plugin_so(struct plugin_rec *rec)
+{
+	void *so;
+	int (*reg)(void);
+	int res;
+
+	if(!(so = dlopen(rec->path, RTLD_LAZY))) {
+		fprintf(stderr, "failed to open plugin: %s: %s\n", rec->path, dlerror());
+		return -1;
+	}
+	/* ISO C has no conversion from void* to a function pointer */
+	if(!(*(void**)&reg = dlsym(so, "register_plugin"))) {
+		fprintf(stderr, "xlivebg: %s is not an xlivebg plugin\n", rec->path);
+		dlclose(so);
+		return -1;
+	}
+
+	loading = rec;
+	res = reg();
+	loading = 0;
+
+	if(res == -1 || rec->plugin == rec->stub) {
+		rec->plugin = rec->stub;
+		free(rec->copy);
+		rec->copy = 0;
+		fprintf(stderr, "xlivebg: failed to load plugin %s from %s\n", rec->stub->name, rec->path);
+		dlclose(so);
+		return -1;
+	}
+	rec->plugin->so = so;
+
+	free_stub(rec->stub);
+	rec->stub = 0;
+	return 0;
+}
+
+int remove_plugin(int idx)
+{
+	if(idx < 0 || idx >= num_plugins) {
+		return -1;
+	}
+
+	if(plugins[idx].plugin->so) {
+		dlclose(plugins[idx].plugin->so);
+	}
+	free_stub(plugins[idx].stub);
+	free(plugins[idx].copy);
+	free(plugins[idx].path);
+
+	if(idx == num_plugins - 1) {
+		num_plugins--;
+		return 0;
+	}
+
+	memmove(plugins + idx, plugins + idx + 1, (num_plugins - idx - 1) * sizeof *plugins);
+	num_plugins--;
+	return 0;
+}
+
+
+#ifdef HAVE_INOTIFY
+/* ---- hot reload of plugins modified on disk ---- */
+struct dir_watch {
+	int wd;
+	char *path;
+};
+
+static int watch_fd = -1;
+static struct dir_watch *watch;
+static int num_watch;
+
+static void plugin_dir_event(int fd, void *cls);
+
+static void watch_plugin_dir(const char *dirpath)
+{
+	int wd;
+	struct dir_watch *tmp;
+
+	if(watch_fd == -1) {
+		if((watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) == -1) {
+			perror("xlivebg: failed to initialize inotify, plugin hot reload disabled");
+			return;
+		}
+		if(evloop_add(watch_fd, plugin_dir_event, 0) == -1) {
+			close(watch_fd);
+			watch_fd = -1;
+			return;
 		}
 	}
 
-	closedir(dir);
-	return num;
+	if((wd = inotify_add_watch(watch_fd, dirpath, IN_CLOSE_WRITE | IN_MOVED_TO |
+					IN_DELETE | IN_MOVED_FROM)) == -1) {
+		fprintf(stderr, "xlivebg: failed to watch plugin directory %s: %s\n", dirpath, strerror(errno));
+		return;
+	}
+
+	if(!(tmp = realloc(watch, (num_watch + 1) * sizeof *watch))) {
+		inotify_rm_watch(watch_fd, wd);
+		return;
+	}
+	watch = tmp;
+	watch[num_watch].wd = wd;
+	if(!(watch[num_watch].path = strdup(dirpath))) {
+		inotify_rm_watch(watch_fd, wd);
+		return;
+	}
+	num_watch++;
 }
 
-struct xlivebg_plugin *get_plugin(int idx)
+static void close_plugin_watch(void)
 {
-	return plugins[idx];
-}
+	int i;
 
-int get_plugin_count(void)
-{
-	return num_plugins;
+	if(watch_fd == -1) return;
+
+	evloop_remove(watch_fd);
+	close(watch_fd);
+	watch_fd = -1;
+
+	for(i=0; i<num_watch; i++) {
+		free(watch[i].path);
+	}
+	free(watch);
+	watch = 0;
+	num_watch = 0;
 }
 
-struct xlivebg_plugin *find_plugin(const char *name)
+static struct plugin_rec *find_rec_path(const char *path)
 {
 	int i;
 
 	for(i=0; i<num_plugins; i++) {
-		if(strcasecmp(name, plugins[i]->name) == 0) {
-			return plugins[i];
+		if(plugins[i].path && strcmp(plugins[i].path, path) == 0) {
+			return plugins + i;
 		}
 	}
 	return 0;
 }
 
-void activate_plugin(struct xlivebg_plugin *plugin)
+/* if nothing is active after a reload or removal, fall back to any plugin */
+static void activate_any(void)
 {
-	printf("xlivebg: activating plugin: %s\n", plugin->name);
-	if(act) {
-		if(act->stop) {
-			act->stop(act->data);
-		}
-		xlivebg_destroy_gl();
+	int i;
+
+	for(i=0; i<num_plugins && !act; i++) {
+		activate_plugin(plugins[i].plugin);
 	}
+}
 
-	if(xlivebg_init_gl() == -1) {
-		fprintf(stderr, "xlivebg: failed to initialize OpenGL\n");
-		return;
+/* stops the plugin if it's active, calls cleanup, and turns it back into a
+ * stub, unloading its shared object, and then loads it again from the same
+ * path. If the new shared object registers a plugin by a different name, it's
+ * replaced by the new one.
+ */
+static void reload_plugin(struct plugin_rec *rec)
+{
+	struct xlivebg_plugin *plugin = rec->plugin;
+	struct xlivebg_plugin *stub;
+	int was_active = plugin == act;
+	int was_layer = rec->layer;
+	struct stat st;
+	char *path;
+	void *so;
+
+	printf("xlivebg: reloading plugin: %s (%s)\n", plugin->name, rec->path);
+
+	if(was_active) {
+		stop_plugin(plugin);
+		act = 0;
+	}
+	if(was_layer) {
+		layer_remove(plugin);
+	}
+	if(rec->init_done) {
+		if(plugin->cleanup) {
+			plugin->cleanup(plugin->data);
+		}
+		gltrack_release(plugin);
+		rec->init_done = 0;
 	}
 
-	if(plugin->start) {
-		if(plugin->start(msec, plugin->data) == -1) {
-			fprintf(stderr, "xlivebg: plugin %s failed to start\n", plugin->name);
-			if(act && act != plugin) {
-				activate_plugin(act);
-				return;
-			}
+	if(!rec->stub) {
+		/* the plugin structure lives in the shared object, copy what we need */
+		if(!(stub = calloc(1, sizeof *stub)) || !(stub->name = strdup(plugin->name))) {
+			free(stub);
+			return;
 		}
+		stub->desc = plugin->desc ? strdup(plugin->desc) : 0;
+		stub->props = plugin->props ? strdup(plugin->props) : 0;
+		stub->upd_interval = plugin->upd_interval;
+
+		so = plugin->so;
+		rec->plugin = rec->stub = stub;
+		dlclose(so);
+		free(rec->copy);
+		rec->copy = 0;
 	}
-	act = plugin;
 
-	upd_interval_usec = act->upd_interval;
+	if(load_plugin_so(rec) == -1) {
+		path = alloca(strlen(rec->path) + 1);
+		strcpy(path, rec->path);
+		remove_plugin(rec - plugins);
 
-	free(cfg.act_plugin);
-	cfg.act_plugin = strdup(plugin->name);
-}
+		if(stat(path, &st) != -1) {
+			load_plugin_file(path, &st);
+		}
+		if(was_active) {
+			activate_any();
+		}
+		return;
+	}
 
-struct xlivebg_plugin *get_active_plugin(void)
-{
-	return act;
+	if(was_active) {
+		if(activate_plugin(rec->plugin) == -1) {
+			activate_any();
+		}
+	} else if(was_layer) {
+		layer_setup();
+	}
 }
 
-int remove_plugin(int idx)
+static void plugin_file_changed(const char *path, unsigned int mask)
 {
-	if(idx < 0 || idx >= num_plugins) {
-		return -1;
+	struct plugin_rec *rec = find_rec_path(path);
+	struct stat st;
+
+	if(mask & (IN_DELETE | IN_MOVED_FROM)) {
+		/* the code of an active plugin stays mapped, keep using it */
+		if(rec && rec->plugin != act) {
+			printf("xlivebg: removing plugin: %s\n", rec->plugin->name);
+			if(rec->init_done) {
+				if(rec->plugin->cleanup) {
+					rec->plugin->cleanup(rec->plugin->data);
+				}
+				gltrack_release(rec->plugin);
+			}
+			remove_plugin(rec - plugins);
+		}
+		return;
 	}
 
-	dlclose(plugins[idx]->so);
+	if(stat(path, &st) == -1 || !S_ISREG(st.st_mode)) {
+		return;
+	}
 
-	if(idx == num_plugins - 1) {
-		num_plugins--;
-		return 0;
+	if(rec) {
+		reload_plugin(rec);
+	} else {
+		load_plugin_file(path, &st);
 	}
+}
 
-	memmove(plugins + idx, plugins + idx + 1, (num_plugins - idx - 1) * sizeof *plugins);
-	num_plugins--;
-	return 0;
+static void plugin_dir_event(int fd, void *cls)
+{
+	union {
+		struct inotify_event ev;
+		char buf[4096];
+	} evbuf;
+	struct inotify_event *ev;
+	char *ptr, *end, *dir;
+	char fname[1024];
+	int i, len;
+	ssize_t sz;
+
+	while((sz = read(fd, evbuf.buf, sizeof evbuf.buf)) > 0) {
+		ptr = evbuf.buf;
+		end = ptr + sz;
+		while(ptr < end) {
+			ev = (struct inotify_event*)ptr;
+			ptr += sizeof *ev + ev->len;
+
+			/* only consider shared objects, to skip editor backups and the like */
+			if(!ev->len || (len = strlen(ev->name)) < 3 || strcmp(ev->name + len - 3, ".so") != 0) {
+				continue;
+			}
+
+			dir = 0;
+			for(i=0; i<num_watch; i++) {
+				if(watch[i].wd == ev->wd) {
+					dir = watch[i].path;
+					break;
+				}
+			}
+			if(!dir) continue;
+
+			snprintf(fname, sizeof fname, "%s/%s", dir, ev->name);
+			fname[sizeof fname - 1] = 0;
+			plugin_file_changed(fname, ev->mask);
+		}
+	}
 }
+#endif	/* HAVE_INOTIFY */
 
 
 /* ---- plugin API ---- */
 
+/* plugins calling this were built before the structure size was passed, when
+ * it ended with the data and so members.
+ */
+#undef xlivebg_register_plugin
 int xlivebg_register_plugin(struct xlivebg_plugin *plugin)
 {
+	return xlivebg_register_plugin2(plugin, PLUGIN_SIZE_V1);
+}
+
+int xlivebg_register_plugin2(struct xlivebg_plugin *plugin, int size)
+{
+	struct xlivebg_plugin *copy = 0;
+
+	if(size < PLUGIN_SIZE_V1) {
+		fprintf(stderr, "xlivebg: failed to register plugin: invalid structure size: %d\n", size);
+		return -1;
+	}
+	if(size < (int)sizeof *plugin) {
+		if(!(copy = calloc(1, sizeof *copy))) {
+			perror("xlivebg_register_plugin");
+			return -1;
+		}
+		memcpy(copy, plugin, size);
+		plugin = copy;
+	}
+
+	if(loading) {
+		/* loading the shared object of a cached plugin, replace its stub */
+		if(loading->plugin != loading->stub || strcasecmp(plugin->name, loading->stub->name) != 0) {
+			fprintf(stderr, "xlivebg: unexpected plugin \"%s\" registered by %s\n",
+					plugin->name, loading->path);
+			free(copy);
+			return -1;
+		}
+		loading->plugin = plugin;
+		loading->copy = copy;
+		return 0;
+	}
+
 	if(find_plugin(plugin->name)) {
 		fprintf(stderr, "xlivebg: failed to register \"%s\": a plugin by that name already exists\n",
 				plugin->name);
+		free(copy);
 		return -1;
 	}
 
 	if(num_plugins >= max_plugins) {
 		int nmax = max_plugins ? max_plugins * 2 : 16;
-		struct xlivebg_plugin **tmp = realloc(plugins, nmax * sizeof *plugins);
+		struct plugin_rec *tmp = realloc(plugins, nmax * sizeof *plugins);
 		if(!tmp) {
 			perror("xlivebg_register_plugin");
+			free(copy);
 			return -1;
 		}
 		plugins = tmp;
 		max_plugins = nmax;
 	}
-	plugins[num_plugins++] = plugin;
+	plugins[num_plugins].plugin = plugin;
+	plugins[num_plugins].copy = copy;
+	plugins[num_plugins].init_done = 0;
+	plugins[num_plugins].stop_time = 0;
+	plugins[num_plugins].quality_level = -1;
+	plugins[num_plugins].path = 0;
+	plugins[num_plugins].stub = 0;
+	num_plugins++;
 	printf("xlivebg: registered plugin: %s\n", plugin->name);
 	return 0;
 }
 
+/* plugins only get to see the screens which are not covered by fullscreen
+ * windows, so they don't waste any time drawing them.
+ */
 int xlivebg_screen_count(void)
 {
-	return num_screens;
+	return num_vis_screens;
 }
 
 struct xlivebg_screen *xlivebg_screen(int idx)
 {
-	return screen + idx;
+	return idx < num_vis_screens ? screen + vis_screen[idx] : screen + idx;
 }
 
 struct xlivebg_image *xlivebg_bg_image(int scr)
@@ -254,6 +1118,18 @@ int xlivebg_memory_image(struct xlivebg_image *img, void *data, long datasz)
 	return 0;
 }
 
+void xlivebg_destroy_image(struct xlivebg_image *img)
+{
+	if(!img) return;
+
+	remove_image(img);
+	if(img->tex) {
+		glDeleteTextures(1, &img->tex);
+		img->tex = 0;
+	}
+	destroy_image(img);
+}
+
 unsigned int xlivebg_image_texture(struct xlivebg_image *img)
 {
 	update_texture(img);
@@ -479,13 +1355,6 @@ void xlivebg_gl_viewport(int sidx)
 
 void xlivebg_clear(unsigned int mask)
 {
-	static float varr[2][24] = {
-		{0, 0, 0, 1, 1, 0, 0, 0, 0, -1, 1, 0, 0, 0, 0, -1, -1, 0, 0, 0, 0, 1, -1, 0},
-		{5, 5, 5, -1, 1, 0, 5, 5, 5, -1, -1, 0, 5, 5, 5, 1, -1, 0, 5, 5, 5, 1, 1, 0}
-	};
-	float *vptr;
-	int i, cur_prog = 0;
-
 	if(cfg.bgmode < 0 || cfg.bgmode > 2) return;
 
 	if(cfg.bgmode == XLIVEBG_BG_SOLID) {
@@ -493,57 +1362,9 @@ void xlivebg_clear(unsigned int mask)
 		glClear(mask);
 		return;
 	}
-	vptr = varr[cfg.bgmode - 1];
 
 	glClear(mask & ~GL_COLOR_BUFFER_BIT);
-
-	glPushAttrib(GL_ENABLE_BIT | GL_TRANSFORM_BIT);
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-	glLoadIdentity();
-	glMatrixMode(GL_PROJECTION);
-	glPushMatrix();
-	glLoadIdentity();
-
-	glDisable(GL_LIGHTING);
-	glDisable(GL_DEPTH_TEST);
-	glDisable(GL_BLEND);
-	glDisable(GL_TEXTURE_1D);
-	glDisable(GL_TEXTURE_2D);
-
-	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
-
-	if(xlivebg_gl_use_program) {
-		glGetIntegerv(GL_CURRENT_PROGRAM, &cur_prog);
-		xlivebg_gl_use_program(0);
-	}
-	if(xlivebg_gl_bind_buffer) {
-		xlivebg_gl_bind_buffer(GL_ARRAY_BUFFER, 0);
-	}
-
-	vptr[0] = vptr[6] = cfg.color[0].r;
-	vptr[1] = vptr[7] = cfg.color[0].g;
-	vptr[2] = vptr[8] = cfg.color[0].b;
-	vptr[12] = vptr[18] = cfg.color[1].r;
-	vptr[13] = vptr[19] = cfg.color[1].g;
-	vptr[14] = vptr[20] = cfg.color[1].b;
-
-	glInterleavedArrays(GL_C3F_V3F, 0, vptr);
-
-	for(i=0; i<num_screens; i++) {
-		xlivebg_gl_viewport(i);
-		glDrawArrays(GL_QUADS, 0, 4);
-	}
-
-	glPopClientAttrib();
-	if(cur_prog) {
-		xlivebg_gl_use_program(cur_prog);
-	}
-
-	glPopMatrix();
-	glMatrixMode(GL_MODELVIEW);
-	glPopMatrix();
-	glPopAttrib();
+	bgcache_draw();
 }
 
 void xlivebg_calc_image_proj(int sidx, float img_aspect, float *xform)
@@ -606,7 +1427,101 @@ void xlivebg_gl_image_proj(int scr, float img_aspect)
 
 void xlivebg_mouse_pos(int *mx, int *my)
 {
-	app_getmouse(mx, my);
+	if(!host_mouse(mx, my)) {
+		app_getmouse(mx, my);
+	}
+}
+
+int64_t xlivebg_time_usec(void)
+{
+	return frame_time_usec;
+}
+
+float xlivebg_frame_delta(void)
+{
+	return frame_delta_usec / 1000000.0f;
+}
+
+unsigned long xlivebg_frame_count(void)
+{
+	return frame_count;
+}
+
+int xlivebg_quality(void)
+{
+	int levels;
+
+	/* layers on top of the active plugin always run at their best */
+	if(starting_layer) {
+		levels = starting_layer->quality ? quality_parse_levels(starting_layer->props) : 0;
+		return levels > 0 ? levels - 1 : 0;
+	}
+	return quality_level();
+}
+
+void xlivebg_damage(int scr, int x, int y, int width, int height)
+{
+	struct xlivebg_screen *s = xlivebg_screen(scr);
+
+	/* the render target is upscaled to the window in full every frame, and
+	 * so are frames played back from the loop cache.
+	 */
+	if(rscale_active() || loopcache_active()) return;
+
+	/* clip to the screen, damage_add clips to the root window */
+	if(x < 0) {
+		width += x;
+		x = 0;
+	}
+	if(y < 0) {
+		height += y;
+		y = 0;
+	}
+	if(x + width > s->width) width = s->width - x;
+	if(y + height > s->height) height = s->height - y;
+
+	damage_add(s->x + x, s->y + y, width, height);
+}
+
+unsigned int xlivebg_framebuffer(void)
+{
+	unsigned int fbo = layer_framebuffer();
+	return fbo ? fbo : rscale_framebuffer();
+}
+
+void xlivebg_set_static(int st)
+{
+	if(!called_by_layer()) {
+		still_set_static(st);
+	}
+}
+
+void xlivebg_set_period(long msec)
+{
+	if(!called_by_layer()) {
+		loopcache_set_period(msec);
+	}
+}
+
+int xlivebg_software(void)
+{
+	return sw_render;
+}
+
+void xlivebg_sw_tiles(uint32_t *pixels, int stride, int width, int height,
+		xlivebg_tile_func func, void *cls)
+{
+	swr_tiles(pixels, stride, width, height, func, cls);
+}
+
+int xlivebg_add_fd(int fd, xlivebg_fd_func func, void *cls)
+{
+	return evloop_add(fd, func, cls);
+}
+
+void xlivebg_remove_fd(int fd)
+{
+	evloop_remove(fd);
 }
 
 static char *skip_space(char *s)
@@ -657,14 +1572,16 @@ static int update_builtin_cfg(const char *cfgpath, struct ts_value *tsval)
 		} else {
 			memset(cfg.color, 0, sizeof *cfg.color);
 		}
+		bgcache_invalidate();
 		return 1;
 	}
 	if(strcmp(cfgpath, CFGNAME_COLOR2) == 0) {
 		if(tsval) {
 			memcpy(cfg.color + 1, tsval->vec, sizeof *cfg.color);
 		} else {
-			memset(cfg.color, 0, sizeof *cfg.color);
+			memset(cfg.color + 1, 0, sizeof *cfg.color);
 		}
+		bgcache_invalidate();
 		return 1;
 	}
 	if(strcmp(cfgpath, CFGNAME_BGMODE) == 0) {
@@ -673,6 +1590,7 @@ static int update_builtin_cfg(const char *cfgpath, struct ts_value *tsval)
 		} else {
 			cfg.bgmode = 0;
 		}
+		bgcache_invalidate();
 		return 1;
 	}
 	if(strcmp(cfgpath, CFGNAME_FPS) == 0) {
@@ -690,10 +1608,58 @@ static int update_builtin_cfg(const char *cfgpath, struct ts_value *tsval)
 		cfg.fit = tsval ? cfg_parse_fit(tsval->str) : 0;
 		return 1;
 	}
+	if(strcmp(cfgpath, CFGNAME_POWER_IDLE_AFTER) == 0) {
+		cfg.power_idle_after = tsval ? tsval->inum : 0;
+		return 1;
+	}
+	if(strcmp(cfgpath, CFGNAME_POWER_IDLE_FPS) == 0) {
+		cfg.power_idle_fps = tsval ? tsval->inum : DEF_POWER_IDLE_FPS;
+		return 1;
+	}
+	if(strcmp(cfgpath, CFGNAME_CLEANUP_AFTER) == 0) {
+		cfg.cleanup_after = tsval ? tsval->inum : DEF_CLEANUP_AFTER;
+		return 1;
+	}
+	if(strcmp(cfgpath, CFGNAME_QUALITY_BUDGET) == 0) {
+		cfg.quality_budget = tsval ? tsval->inum : DEF_QUALITY_BUDGET;
+		quality_reset();
+		return 1;
+	}
+	if(strcmp(cfgpath, CFGNAME_SW_THREADS) == 0) {
+		cfg.sw_threads = tsval ? tsval->inum : 0;
+		return 1;
+	}
+	if(strcmp(cfgpath, CFGNAME_ISOLATE) == 0) {
+		/* takes effect the next time a plugin is activated */
+		cfg.isolate = tsval ? tsval->inum : 0;
+		return 1;
+	}
+	if(strcmp(cfgpath, CFGNAME_ISOLATE_TIMEOUT) == 0) {
+		cfg.isolate_timeout = tsval ? tsval->inum : DEF_ISOLATE_TIMEOUT;
+		return 1;
+	}
 	if(strcmp(cfgpath, CFGNAME_CROP_ZOOM) == 0) {
 		cfg.zoom = tsval ? tsval->fnum : 1;
 		return 1;
 	}
+	if(strcmp(cfgpath, CFGNAME_RENDER_SCALE) == 0) {
+		cfg.render_scale = tsval ? tsval->fnum : 1;
+		rscale_update();
+		return 1;
+	}
+	if(strcmp(cfgpath, CFGNAME_STATIC_DETECT) == 0) {
+		cfg.static_detect = tsval ? tsval->inum : 0;
+		return 1;
+	}
+	if(strcmp(cfgpath, CFGNAME_LOOP_BUDGET) == 0) {
+		cfg.loop_budget = tsval ? tsval->inum : DEF_LOOP_BUDGET;
+		return 1;
+	}
+	if(strcmp(cfgpath, CFGNAME_LOOP_COMPRESS) == 0) {
+		cfg.loop_compress = tsval ? tsval->inum : 0;
+		loopcache_invalidate();
+		return 1;
+	}
 	if(strcmp(cfgpath, CFGNAME_CROP_DIR) == 0) {
 		if(tsval) {
 			cfg.crop_dir[0] = tsval->vec[0];
@@ -710,12 +1676,32 @@ static int update_builtin_cfg(const char *cfgpath, struct ts_value *tsval)
 static void update_cfg(const char *cfgpath, struct ts_value *tsval)
 {
 	struct xlivebg_plugin *p;
-	char *aname, *ptr, *end;
+	const char *aname;
 	char *buf;
-	int len, aname_len;
+
+	/* any change may affect what the cached layers or loop frames show, or
+	 * a static frame.
+	 */
+	layer_invalidate();
+	loopcache_invalidate();
+	still_invalidate();
 
 	/* first give update_builtin_cfg a chance to handle it */
 	if(update_builtin_cfg(cfgpath, tsval)) {
+		/* the host process has its own copy of the background settings */
+		if(host_active() && is_bg_cfg(cfgpath)) {
+			host_setcfg(cfgpath, tsval);
+		}
+		return;
+	}
+
+	if(strncmp(cfgpath, "xlivebg.layer.", 14) == 0) {
+		layer_setup();
+		return;
+	}
+	if(strncmp(cfgpath, "xlivebg.output.", 15) == 0) {
+		/* framerates are looked up every frame, scales aren't */
+		rscale_update();
 		return;
 	}
 
@@ -726,14 +1712,28 @@ static void update_cfg(const char *cfgpath, struct ts_value *tsval)
 	buf = alloca(strlen(p->name) + 16);
 	sprintf(buf, "xlivebg.%s.", p->name);
 	if(!strstr(cfgpath, buf)) {
-		/* this property has nothing to do with the current plugin */
+		/* this property has nothing to do with the current plugin, but it
+		 * might be one of the layers above it.
+		 */
+		update_layer_cfg(cfgpath);
+		return;
+	}
+
+	/* the host process has its own copy of the configuration, pass the change
+	 * on, unless the plugin has to be restarted anyway.
+	 */
+	if(host_active()) {
+		if(p->props && p->prop) {
+			host_setcfg(cfgpath, tsval);
+		} else {
+			host_restart();
+		}
 		return;
 	}
 
 	/* if the plugin didn't specify a property list or a prop callback, we'll have to restart it */
 	if(!p->props || !p->prop) {
 		printf("update_cfg: restarting live wallpaper\n");
-		if(p->stop) p->stop(p->data);
 		activate_plugin(p);
 		return;
 	}
@@ -741,12 +1741,102 @@ static void update_cfg(const char *cfgpath, struct ts_value *tsval)
 	if((aname = strrchr(cfgpath, '.'))) {
 		aname++;
 	} else {
-		aname = (char*)cfgpath;
+		aname = cfgpath;
+	}
+
+	if(has_prop(p, aname)) {
+		p->prop(aname, p->data);
+	}
+}
+
+/* forwards changes to the properties of a layer plugin, like update_cfg does
+ * for the active one.
+ */
+static void update_layer_cfg(const char *cfgpath)
+{
+	int i, count;
+	struct xlivebg_plugin *p;
+	const char *aname;
+	char *buf;
+	void *owner;
+
+	count = layer_count();
+	for(i=1; i<count; i++) {
+		p = layer_plugin(i);
+
+		buf = alloca(strlen(p->name) + 16);
+		sprintf(buf, "xlivebg.%s.", p->name);
+		if(!strstr(cfgpath, buf)) continue;
+
+		if(!p->props || !p->prop) {
+			printf("update_cfg: restarting layer %s\n", p->name);
+			layer_remove(p);
+			layer_setup();
+			return;
+		}
+
+		if((aname = strrchr(cfgpath, '.'))) {
+			aname++;
+		} else {
+			aname = cfgpath;
+		}
+		if(has_prop(p, aname)) {
+			owner = gltrack_owner(p);
+			p->prop(aname, p->data);
+			gltrack_owner(owner);
+		}
+		return;
+	}
+}
+
+/* in the host process: applies a change forwarded by host_setcfg to the copy
+ * of the configuration, and lets the hosted plugin know, like update_cfg does
+ * for an in-process one. Only the background settings and the properties of
+ * the plugin are ever forwarded, and none of xlivebg's caches exist here.
+ */
+int update_hosted_cfg(struct xlivebg_plugin *p, const char *cfgpath, struct ts_value *tsval)
+{
+	struct ts_value *aval = 0;
+	struct ts_attr *attr;
+	const char *aname;
+
+	if(tsval) {
+		if(!(aval = touch_node(cfgpath))) {
+			return -1;
+		}
+		ts_destroy_value(aval);
+		if(ts_copy_value(aval, tsval) == -1) {
+			ts_init_value(aval);
+			return -1;
+		}
+	} else if((attr = ts_lookup(cfg.ts, cfgpath))) {
+		ts_remove_attr(attr->node, attr);
+		ts_free_attr(attr);
+	}
+
+	if(is_bg_cfg(cfgpath)) {
+		update_builtin_cfg(cfgpath, aval);
+		return 0;
+	}
+
+	if((aname = strrchr(cfgpath, '.'))) {
+		aname++;
+	} else {
+		aname = cfgpath;
 	}
-	aname_len = strlen(aname);
+	if(p->prop && has_prop(p, aname)) {
+		p->prop(aname, p->data);
+	}
+	return 0;
+}
+
+/* checks to see if the attribute name matches any attributes declared by the plugin */
+static int has_prop(struct xlivebg_plugin *plugin, const char *aname)
+{
+	char *ptr, *end;
+	int len, aname_len = strlen(aname);
 
-	/* check to see if the attribute name matches any attributes declared by the plugin */
-	ptr = p->props;
+	ptr = plugin->props;
 	while((ptr = strstr(ptr, "id"))) {
 		ptr = skip_space(ptr + 3);
 		if(*ptr != '=') continue;
@@ -758,11 +1848,10 @@ static void update_cfg(const char *cfgpath, struct ts_value *tsval)
 
 		len = end - ptr;
 		if(len == aname_len && memcmp(aname, ptr, len) == 0) {
-			/* found at least one match, notify the plugin and return */
-			p->prop(aname, p->data);
-			break;
+			return 1;
 		}
 	}
+	return 0;
 }
 
 static const char *get_builtin_str(const char *cfgpath)
@@ -784,6 +1873,9 @@ static float *get_builtin_num(const char *cfgpath)
 	if(strcmp(cfgpath, CFGNAME_CROP_ZOOM) == 0) {
 		return &cfg.zoom;
 	}
+	if(strcmp(cfgpath, CFGNAME_RENDER_SCALE) == 0) {
+		return &cfg.render_scale;
+	}
 	return 0;
 }
 
@@ -798,6 +1890,36 @@ static int *get_builtin_int(const char *cfgpath)
 	if(strcmp(cfgpath, CFGNAME_BGMODE) == 0) {
 		return &cfg.bgmode;
 	}
+	if(strcmp(cfgpath, CFGNAME_POWER_IDLE_AFTER) == 0) {
+		return &cfg.power_idle_after;
+	}
+	if(strcmp(cfgpath, CFGNAME_POWER_IDLE_FPS) == 0) {
+		return &cfg.power_idle_fps;
+	}
+	if(strcmp(cfgpath, CFGNAME_CLEANUP_AFTER) == 0) {
+		return &cfg.cleanup_after;
+	}
+	if(strcmp(cfgpath, CFGNAME_QUALITY_BUDGET) == 0) {
+		return &cfg.quality_budget;
+	}
+	if(strcmp(cfgpath, CFGNAME_SW_THREADS) == 0) {
+		return &cfg.sw_threads;
+	}
+	if(strcmp(cfgpath, CFGNAME_ISOLATE) == 0) {
+		return &cfg.isolate;
+	}
+	if(strcmp(cfgpath, CFGNAME_ISOLATE_TIMEOUT) == 0) {
+		return &cfg.isolate_timeout;
+	}
+	if(strcmp(cfgpath, CFGNAME_STATIC_DETECT) == 0) {
+		return &cfg.static_detect;
+	}
+	if(strcmp(cfgpath, CFGNAME_LOOP_BUDGET) == 0) {
+		return &cfg.loop_budget;
+	}
+	if(strcmp(cfgpath, CFGNAME_LOOP_COMPRESS) == 0) {
+		return &cfg.loop_compress;
+	}
 	return 0;
 }
 
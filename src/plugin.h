@@ -30,9 +30,28 @@ int get_plugin_count(void);
 
 struct xlivebg_plugin *find_plugin(const char *name);
 
-void activate_plugin(struct xlivebg_plugin *plugin);
+/* initializes the plugin if it's the first time it's activated, and starts
+ * it. Returns -1 if the plugin failed to initialize.
+ */
+int activate_plugin(struct xlivebg_plugin *plugin);
 struct xlivebg_plugin *get_active_plugin(void);
 
+/* initializes the plugin if needed, and starts it as a layer on top of the
+ * active plugin (see layer.h). Returns the plugin, which may have been loaded
+ * from its shared object in the process, or null on failure.
+ */
+struct xlivebg_plugin *start_layer_plugin(struct xlivebg_plugin *plugin);
+void stop_layer_plugin(struct xlivebg_plugin *plugin);
+
+void cleanup_inactive_plugins(int64_t now);
+void cleanup_plugins(void);
+
 int remove_plugin(int idx);
 
+struct ts_value;
+/* in the host process, applies a configuration change forwarded by xlivebg,
+ * and passes it on to the hosted plugin. tsval is null if it was removed.
+ */
+int update_hosted_cfg(struct xlivebg_plugin *plugin, const char *cfgpath, struct ts_value *tsval);
+
 #endif	/* PLUGIN_H_ */
@@ -0,0 +1,172 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <X11/Xlib.h>
+#ifdef HAVE_XSS
+#include <X11/extensions/scrnsaver.h>
+#endif
+#ifdef HAVE_DPMS
+#include <X11/extensions/dpms.h>
+#endif
+#include "power.h"
+#include "cfg.h"
+
+/* idle time and DPMS state can only be polled, do it once per second */
+#define POLL_INTERVAL	1000000
+
+static Display *dpy;
+static Window root;
+static int state = POWER_ACTIVE;
+static long idle_msec;
+static int64_t next_poll = -1;
+
+#ifdef HAVE_XSS
+static int have_xss, xss_evbase;
+static XScreenSaverInfo *xss_info;
+#endif
+#ifdef HAVE_DPMS
+static int have_dpms;
+#endif
+
+static const char *state_names[] = {"active", "idle", "screensaver", "dpms-off"};
+
+void power_init(Display *d, Window r)
+{
+	int errbase, avail = 0;
+
+	dpy = d;
+	root = r;
+
+#ifdef HAVE_XSS
+	if((have_xss = XScreenSaverQueryExtension(dpy, &xss_evbase, &errbase))) {
+		if((xss_info = XScreenSaverAllocInfo())) {
+			XScreenSaverSelectInput(dpy, root, ScreenSaverNotifyMask);
+		} else {
+			have_xss = 0;
+		}
+	}
+	printf("power: MIT-SCREEN-SAVER extension %s\n", have_xss ? "available" : "not available");
+	avail |= have_xss;
+#endif
+#ifdef HAVE_DPMS
+	{
+		int evbase;
+		have_dpms = DPMSQueryExtension(dpy, &evbase, &errbase) && DPMSCapable(dpy);
+		printf("power: DPMS %s\n", have_dpms ? "available" : "not available");
+		avail |= have_dpms;
+	}
+#endif
+	(void)errbase;
+	next_poll = avail ? 0 : -1;
+}
+
+int power_xevent(XEvent *ev)
+{
+#ifdef HAVE_XSS
+	if(have_xss && ev->type == xss_evbase + ScreenSaverNotify) {
+		/* force a re-evaluation on the next update */
+		next_poll = 0;
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+int power_update(int64_t now)
+{
+	int prev_state = state;
+
+	if(next_poll < 0 || now < next_poll) {
+		return state;
+	}
+	next_poll = now + POLL_INTERVAL;
+	state = POWER_ACTIVE;
+
+#ifdef HAVE_DPMS
+	if(have_dpms) {
+		CARD16 level;
+		BOOL enabled;
+
+		if(DPMSInfo(dpy, &level, &enabled) && enabled && level != DPMSModeOn) {
+			state = POWER_DPMS_OFF;
+		}
+	}
+#endif
+#ifdef HAVE_XSS
+	if(have_xss && XScreenSaverQueryInfo(dpy, root, xss_info)) {
+		idle_msec = xss_info->idle;
+		if(state == POWER_ACTIVE && xss_info->state == ScreenSaverOn) {
+			state = POWER_SAVER;
+		}
+	}
+#endif
+	if(state == POWER_ACTIVE && cfg.power_idle_after > 0 &&
+			idle_msec >= cfg.power_idle_after * 1000L) {
+		state = POWER_IDLE;
+	}
+
+	if(state != prev_state) {
+		printf("power: %s -> %s\n", state_names[prev_state], state_names[state]);
+	}
+	return state;
+}
+
+int power_state(void)
+{
+	return state;
+}
+
+const char *power_state_name(int s)
+{
+	return state_names[s];
+}
+
+long power_idle_msec(void)
+{
+	return idle_msec;
+}
+
+long power_interval(long interval)
+{
+	long idle_interval;
+
+	switch(state) {
+	case POWER_IDLE:
+		if(interval <= 0) {
+			break;	/* static plugins don't redraw anyway */
+		}
+		if(cfg.power_idle_fps <= 0) {
+			return -1;
+		}
+		idle_interval = 1000000 / cfg.power_idle_fps;
+		return interval > idle_interval ? interval : idle_interval;
+
+	case POWER_SAVER:
+	case POWER_DPMS_OFF:
+		return -1;
+
+	default:
+		break;
+	}
+	return interval;
+}
+
+int64_t power_next_poll(void)
+{
+	return next_poll;
+}
@@ -0,0 +1,53 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef POWER_H_
+#define POWER_H_
+
+#include <inttypes.h>
+#include <X11/Xlib.h>
+
+/* Power policy: throttles or stops drawing while the user is idle, the
+ * screensaver is active, or the monitors are turned off by DPMS.
+ */
+enum {
+	POWER_ACTIVE,	/* normal operation */
+	POWER_IDLE,		/* user idle for longer than power.idle_after seconds */
+	POWER_SAVER,	/* screensaver active */
+	POWER_DPMS_OFF	/* monitors in DPMS standby, suspend or off */
+};
+
+void power_init(Display *dpy, Window root);
+
+/* handles screensaver notification events, returns 1 if the event was consumed */
+int power_xevent(XEvent *ev);
+
+/* re-evaluates the power state, if it's time to poll again. Returns the state */
+int power_update(int64_t now);
+int power_state(void);
+const char *power_state_name(int state);
+long power_idle_msec(void);
+
+/* returns the effective update interval for the current power state, given
+ * the requested interval, or -1 if nothing should be drawn at all.
+ */
+long power_interval(long interval);
+
+/* absolute time of the next poll, or -1 if there's nothing to poll */
+int64_t power_next_poll(void);
+
+#endif	/* POWER_H_ */
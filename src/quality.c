@@ -0,0 +1,153 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "quality.h"
+#include "stats.h"
+#include "opengl.h"
+#include "cfg.h"
+#include "host.h"
+#include "loopcache.h"
+
+/* frames to skip after a level change, before measuring again, to avoid
+ * counting any one-off cost of the change itself.
+ */
+#define SETTLE_FRAMES	15
+/* frames the cost has to stay well below the budget before stepping up. It
+ * doubles every time we have to step down, to avoid oscillating between two
+ * levels, when one is just a bit too slow.
+ */
+#define MIN_UP_HOLD		60
+#define MAX_UP_HOLD		3600
+
+static void set_level(int lvl);
+
+static struct xlivebg_plugin *plugin;
+static int levels = 1, level;
+static int frames;		/* frames measured since the last change */
+static int up_hold = MIN_UP_HOLD;
+static float avg_cost;	/* exponential moving average of the frame cost */
+
+
+int quality_parse_levels(const char *props)
+{
+	const char *ptr;
+	int n;
+
+	if(!props || !(ptr = strstr(props, "quality_levels"))) {
+		return 0;
+	}
+	ptr += 14;
+	while(*ptr && isspace(*ptr)) ptr++;
+	if(*ptr++ != '=') return 0;
+
+	n = atoi(ptr);
+	return n > 0 ? n : 0;
+}
+
+void quality_activate(struct xlivebg_plugin *p, int lvl)
+{
+	plugin = p;
+	levels = p->quality ? quality_parse_levels(p->props) : 0;
+	if(levels <= 0) {
+		levels = 1;
+	}
+
+	if(lvl < 0 || lvl >= levels || cfg.quality_budget <= 0) {
+		lvl = levels - 1;
+	}
+	level = lvl;
+	up_hold = MIN_UP_HOLD;
+	quality_reset();
+}
+
+int quality_level(void)
+{
+	return level;
+}
+
+int quality_levels(void)
+{
+	return levels;
+}
+
+void quality_reset(void)
+{
+	frames = -SETTLE_FRAMES;
+	avg_cost = 0;
+}
+
+void quality_update(void)
+{
+	long cost, gpu;
+	long budget = (long)cfg.quality_budget * 1000;
+
+	if(levels <= 1) return;
+	/* played back frames cost next to nothing, and a level change would only
+	 * throw away the cached loop. Keep the level it was cached at.
+	 */
+	if(loopcache_active()) return;
+	if(budget <= 0) {
+		/* adaptive quality disabled, go back to the best level */
+		if(level < levels - 1) {
+			set_level(levels - 1);
+		}
+		return;
+	}
+
+	/* the frame cost is the larger of the CPU time spent in draw, and the GPU
+	 * time it took to render the frame, if we can measure it.
+	 */
+	cost = stats_last(STATS_DRAW);
+	if(gl_have_timer_query && (gpu = stats_last(STATS_GPU)) > cost) {
+		cost = gpu;
+	}
+	if(cost < 0) return;
+
+	if(++frames <= 0) return;
+	if(frames == 1) {
+		avg_cost = cost;
+	} else {
+		avg_cost += ((float)cost - avg_cost) * 0.1f;
+	}
+	if(frames < SETTLE_FRAMES) return;
+
+	if(avg_cost > budget && level > 0) {
+		set_level(level - 1);
+		up_hold *= 2;
+		if(up_hold > MAX_UP_HOLD) up_hold = MAX_UP_HOLD;
+
+	} else if(avg_cost < budget / 2 && frames >= up_hold && level < levels - 1) {
+		set_level(level + 1);
+	}
+}
+
+static void set_level(int lvl)
+{
+	printf("xlivebg: %s quality %d -> %d (frame cost: %.1f ms, budget: %d ms)\n",
+			plugin->name, level, lvl, avg_cost / 1000.0f, cfg.quality_budget);
+
+	level = lvl;
+	/* hosted plugins pick up the new level with the next frame request */
+	if(!host_active()) {
+		plugin->quality(level, plugin->data);
+	}
+	quality_reset();
+}
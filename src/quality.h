@@ -0,0 +1,47 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef QUALITY_H_
+#define QUALITY_H_
+
+#include "xlivebg.h"
+
+/* Adaptive quality: plugins declaring quality levels in their property list
+ * (quality_levels = N) are stepped between level 0 (fastest) and N-1 (best),
+ * to keep the measured per-frame cost within the configured frame budget.
+ */
+
+/* parses the number of quality levels declared in a property list, 0 if none */
+int quality_parse_levels(const char *props);
+
+/* called when a plugin is activated, before it's started, with the level it
+ * had last time (or -1 to start at the best level). Plugins without quality
+ * levels or a quality callback always run at level 0 of 1.
+ */
+void quality_activate(struct xlivebg_plugin *plugin, int level);
+int quality_level(void);
+int quality_levels(void);
+
+/* discards the frame cost measured so far (after suspend, reconfiguration...) */
+void quality_reset(void);
+
+/* called once per frame after it's done, steps the quality level up or down
+ * if the frame cost has been outside the budget for a while.
+ */
+void quality_update(void);
+
+#endif	/* QUALITY_H_ */
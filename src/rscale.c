@@ -0,0 +1,267 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "opengl.h"
+#include "rscale.h"
+#include "app.h"
+#include "cfg.h"
+#include "layer.h"
+#include "bgcache.h"
+#include "damage.h"
+#include "loopcache.h"
+#include "gltrack.h"
+
+static float screen_scale(int idx);
+static void set_vports(float max_scale);
+static int create_target(void);
+static void destroy_target(void);
+
+static int active;
+static int width, height;		/* size of the render target */
+static float scale[MAX_SCR];
+static int win_vport[MAX_SCR][4];	/* where each screen goes on the window */
+
+static unsigned int fbo, tex;
+static int tex_width, tex_height;
+static int valid;
+static int failed;	/* couldn't create the framebuffer at this size, draw directly */
+
+
+void rscale_update(void)
+{
+	int i;
+	float max_scale = 0;
+	static int warned;
+
+	active = 0;
+	for(i=0; i<num_screens; i++) {
+		scale[i] = screen_scale(i);
+		if(scale[i] < 1.0f) active = 1;
+		if(scale[i] > max_scale) max_scale = scale[i];
+	}
+
+	if(sw_render) {
+		active = 0;
+	} else if(active && !gl_have_fbo_blit) {
+		if(!warned) {
+			fprintf(stderr, "xlivebg: render scaling needs framebuffer blits, ignoring render_scale\n");
+			warned = 1;
+		}
+		active = 0;
+	}
+
+	if(active) {
+		width = (int)ceil(scr_width * max_scale);
+		height = (int)ceil(scr_height * max_scale);
+	} else {
+		width = scr_width;
+		height = scr_height;
+		if(fbo) destroy_target();
+	}
+	set_vports(active ? max_scale : 1.0f);
+
+	valid = 0;
+	failed = 0;
+	layer_invalidate();
+	bgcache_invalidate();
+	loopcache_invalidate();
+	damage_invalidate();
+}
+
+void rscale_destroy_gl(void)
+{
+	destroy_target();
+}
+
+int rscale_active(void)
+{
+	return active;
+}
+
+int rscale_width(void)
+{
+	return width;
+}
+
+int rscale_height(void)
+{
+	return height;
+}
+
+int rscale_begin(void)
+{
+	if(!active) return 0;
+
+	if(fbo && (tex_width != width || tex_height != height)) {
+		destroy_target();
+	}
+	if(!fbo && (failed || create_target() == -1)) {
+		/* fall back to full resolution until the next update */
+		failed = 1;
+		active = 0;
+		width = scr_width;
+		height = scr_height;
+		set_vports(1.0f);
+		layer_invalidate();
+		bgcache_invalidate();
+		loopcache_invalidate();
+		return 0;
+	}
+
+	xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, fbo);
+	return 1;
+}
+
+void rscale_end(void)
+{
+	int i, idx;
+	int *src, *dst;
+
+	if(!active || !fbo) return;
+
+	xlivebg_gl_bind_framebuffer(GL_READ_FRAMEBUFFER, fbo);
+	xlivebg_gl_bind_framebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	/* blits are clipped by the scissor rectangle */
+	glDisable(GL_SCISSOR_TEST);
+
+	for(i=0; i<num_vis_screens; i++) {
+		idx = vis_screen[i];
+		src = screen[idx].vport;
+		dst = win_vport[idx];
+		xlivebg_gl_blit_framebuffer(src[0], src[1], src[0] + src[2], src[1] + src[3],
+				dst[0], dst[1], dst[0] + dst[2], dst[1] + dst[3],
+				GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	}
+
+	xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+	valid = 1;
+}
+
+int rscale_valid(void)
+{
+	return active && valid;
+}
+
+unsigned int rscale_framebuffer(void)
+{
+	return active ? fbo : 0;
+}
+
+/* the scale of the output section of this screen if there is one, or the
+ * global render_scale.
+ */
+static float screen_scale(int idx)
+{
+	float s = cfg_output_scale(idx, screen[idx].name);
+
+	if(s <= 0.0f) s = cfg.render_scale;
+	if(s < RSCALE_MIN) return RSCALE_MIN;
+	return s > 1.0f ? 1.0f : s;
+}
+
+/* lays out the screens on the render target, scaled by max_scale, and then
+ * shrunk in place to their own scale. The top-left corners stay put, so that
+ * the screens can't overlap. With max_scale 1 and no scaling, the viewports
+ * end up where they are on the window.
+ */
+static void set_vports(float max_scale)
+{
+	int i, top;
+	int *vp;
+	struct xlivebg_screen *scr;
+
+	for(i=0; i<num_screens; i++) {
+		scr = screen + i;
+		vp = win_vport[i];
+		vp[0] = scr->x;
+		vp[1] = scr->root_height - scr->height - scr->y;
+		vp[2] = scr->width;
+		vp[3] = scr->height;
+
+		if(!active) {
+			memcpy(scr->vport, vp, sizeof scr->vport);
+			continue;
+		}
+
+		top = (int)((vp[1] + vp[3]) * max_scale + 0.5f);
+		scr->vport[0] = (int)(vp[0] * max_scale + 0.5f);
+		scr->vport[2] = (int)(vp[2] * scale[i] + 0.5f);
+		scr->vport[3] = (int)(vp[3] * scale[i] + 0.5f);
+		if(scr->vport[2] < 1) scr->vport[2] = 1;
+		if(scr->vport[3] < 1) scr->vport[3] = 1;
+		scr->vport[1] = top - scr->vport[3];
+		if(scr->vport[1] < 0) scr->vport[1] = 0;
+	}
+}
+
+static int create_target(void)
+{
+	void *owner;
+	unsigned int status;
+
+	/* the render target belongs to the core, whichever plugin is drawing */
+	owner = gltrack_owner(0);
+	glGenTextures(1, &tex);
+	gltrack_owner(owner);
+
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	xlivebg_gl_gen_framebuffers(1, &fbo);
+	xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, fbo);
+	xlivebg_gl_framebuffer_texture_2d(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+	status = xlivebg_gl_check_framebuffer_status(GL_FRAMEBUFFER);
+	if(status == GL_FRAMEBUFFER_COMPLETE) {
+		glClearColor(0, 0, 0, 1);
+		glClear(GL_COLOR_BUFFER_BIT);
+	}
+	xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+
+	if(status != GL_FRAMEBUFFER_COMPLETE) {
+		fprintf(stderr, "xlivebg: failed to create %dx%d render target (status: %x)\n",
+				width, height, status);
+		destroy_target();
+		return -1;
+	}
+
+	printf("xlivebg: rendering at %dx%d, upscaled to %dx%d\n", width, height, scr_width, scr_height);
+	tex_width = width;
+	tex_height = height;
+	valid = 0;
+	return 0;
+}
+
+static void destroy_target(void)
+{
+	if(fbo) {
+		xlivebg_gl_delete_framebuffers(1, &fbo);
+		fbo = 0;
+	}
+	if(tex) {
+		glDeleteTextures(1, &tex);
+		tex = 0;
+	}
+	tex_width = tex_height = 0;
+	valid = 0;
+}
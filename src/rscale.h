@@ -0,0 +1,57 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef RSCALE_H_
+#define RSCALE_H_
+
+/* Render scaling. When xlivebg.render_scale, or the scale of an output
+ * section, is below 1, plugins draw into an offscreen framebuffer where every
+ * screen is that much smaller, and the core upscales each one to its output
+ * with bilinear filtering. The viewports of the screens are adjusted to the
+ * framebuffer, so plugins drawing through xlivebg_gl_viewport (or draw_screen)
+ * don't need to know about it. Needs framebuffer blits, and isn't available
+ * with the software renderer.
+ */
+
+#define RSCALE_MIN	0.1f
+
+/* recomputes the render target and the screen viewports. Called whenever the
+ * outputs, the window size, or the scale options change.
+ */
+void rscale_update(void);
+/* frees the framebuffer, with the OpenGL context still current */
+void rscale_destroy_gl(void);
+
+int rscale_active(void);
+/* size of what plugins draw into: the render target, or the window */
+int rscale_width(void);
+int rscale_height(void);
+
+/* binds the render target for the next frame. Returns 0 if scaling is
+ * inactive, or the framebuffer couldn't be created, in which case plugins
+ * draw directly on the window as usual.
+ */
+int rscale_begin(void);
+/* upscales every visible screen to the window, and binds the window back */
+void rscale_end(void);
+/* returns non-zero if the render target holds the previous frame */
+int rscale_valid(void);
+
+/* returns the framebuffer object of the render target, 0 if inactive */
+unsigned int rscale_framebuffer(void);
+
+#endif	/* RSCALE_H_ */
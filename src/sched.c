@@ -0,0 +1,98 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <time.h>
+#include <sys/time.h>
+#include "sched.h"
+
+static long interval;
+static int64_t deadline = -1;
+static unsigned long dropped;
+
+int64_t sched_time_usec(void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	if(clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+		return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+	}
+#endif
+	{
+		/* fallback for systems without a monotonic clock */
+		struct timeval tv;
+		gettimeofday(&tv, 0);
+		return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+	}
+}
+
+void sched_reset(int64_t now)
+{
+	deadline = interval > 0 ? now : -1;
+}
+
+void sched_set_interval(long usec)
+{
+	if(usec < 0) usec = 0;
+	if(usec == interval) return;
+
+	interval = usec;
+	sched_reset(sched_time_usec());
+}
+
+long sched_interval(void)
+{
+	return interval;
+}
+
+int sched_due(int64_t now)
+{
+	return deadline < 0 || now >= deadline;
+}
+
+void sched_frame_done(int64_t now)
+{
+	int64_t missed;
+
+	if(interval <= 0) {
+		deadline = -1;
+		return;
+	}
+
+	deadline += interval;
+	if(deadline <= now) {
+		missed = (now - deadline) / interval + 1;
+		deadline += missed * interval;
+		dropped += missed;
+	}
+}
+
+int64_t sched_deadline(void)
+{
+	return deadline;
+}
+
+long sched_wait_usec(int64_t now)
+{
+	if(deadline < 0) return -1;
+	return deadline > now ? (long)(deadline - now) : 0;
+}
+
+unsigned long sched_dropped_frames(void)
+{
+	return dropped;
+}
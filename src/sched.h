@@ -0,0 +1,52 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef SCHED_H_
+#define SCHED_H_
+
+#include <inttypes.h>
+
+/* monotonic time in microseconds, unaffected by wall-clock adjustments */
+int64_t sched_time_usec(void);
+
+/* restart the frame schedule with the first deadline at time now */
+void sched_reset(int64_t now);
+
+/* changes the frame interval. A change of interval restarts the schedule */
+void sched_set_interval(long interval);
+long sched_interval(void);
+
+/* returns non-zero if the next frame is due at time now. Always true when
+ * there's no frame interval (draw on events only).
+ */
+int sched_due(int64_t now);
+
+/* marks the current frame as done, and moves the deadline to the next one.
+ * Deadlines are absolute, so lateness of one frame is absorbed by the next,
+ * instead of accumulating. If we're too late and missed whole frames, they
+ * are dropped, while keeping the original frame phase.
+ */
+void sched_frame_done(int64_t now);
+
+/* absolute time of the next frame deadline, or -1 if there isn't one */
+int64_t sched_deadline(void);
+/* microseconds from now until the next deadline, or -1 for no deadline */
+long sched_wait_usec(int64_t now);
+
+unsigned long sched_dropped_frames(void);
+
+#endif	/* SCHED_H_ */
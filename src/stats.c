@@ -0,0 +1,221 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "stats.h"
+#include "sched.h"
+#include "opengl.h"
+
+/* size of the sample window used for the percentiles */
+#define NUM_SAMPLES	512
+/* timer queries in flight, so that we never have to stall waiting for one */
+#define NUM_QUERIES	4
+
+struct ring {
+	long samples[NUM_SAMPLES];
+	int head, count;
+};
+
+static void add_sample(int which, long val);
+static void collect_queries(void);
+static int cmp_long(const void *a, const void *b);
+
+static struct ring ring[NUM_STATS];
+static const char *names[] = {"interval", "draw", "gpu", "swap", "sleep"};
+
+static unsigned long num_frames, dropped_base;
+static int64_t frame_start = -1, prev_frame_start = -1, draw_end;
+static long sleep_accum;
+
+static unsigned int query[NUM_QUERIES];
+static int query_pending[NUM_QUERIES];
+static int cur_query, query_active;
+static int have_queries;
+
+
+void stats_init_gl(void)
+{
+	if(!gl_have_timer_query) {
+		have_queries = 0;
+		return;
+	}
+	xlivebg_gl_gen_queries(NUM_QUERIES, query);
+	memset(query_pending, 0, sizeof query_pending);
+	cur_query = 0;
+	query_active = 0;
+	have_queries = 1;
+}
+
+void stats_destroy_gl(void)
+{
+	if(have_queries) {
+		if(query_active) {
+			xlivebg_gl_end_query(GL_TIME_ELAPSED);
+			query_active = 0;
+		}
+		xlivebg_gl_delete_queries(NUM_QUERIES, query);
+		have_queries = 0;
+	}
+}
+
+void stats_reset(void)
+{
+	memset(ring, 0, sizeof ring);
+	num_frames = 0;
+	dropped_base = sched_dropped_frames();
+	prev_frame_start = -1;
+	sleep_accum = 0;
+}
+
+void stats_break(void)
+{
+	prev_frame_start = -1;
+	sleep_accum = 0;
+}
+
+void stats_frame_begin(int64_t now)
+{
+	if(prev_frame_start >= 0) {
+		add_sample(STATS_INTERVAL, now - prev_frame_start);
+	}
+	prev_frame_start = frame_start = now;
+
+	if(have_queries) {
+		collect_queries();
+		/* if all queries are still in flight, skip measuring this frame */
+		if(!query_pending[cur_query]) {
+			xlivebg_gl_begin_query(GL_TIME_ELAPSED, query[cur_query]);
+			query_active = 1;
+		}
+	}
+}
+
+void stats_draw_done(int64_t now)
+{
+	add_sample(STATS_DRAW, now - frame_start);
+	draw_end = now;
+
+	if(query_active) {
+		xlivebg_gl_end_query(GL_TIME_ELAPSED);
+		query_active = 0;
+		query_pending[cur_query] = 1;
+		cur_query = (cur_query + 1) % NUM_QUERIES;
+	}
+}
+
+void stats_frame_end(int64_t now)
+{
+	add_sample(STATS_SWAP, now - draw_end);
+	add_sample(STATS_SLEEP, sleep_accum);
+	sleep_accum = 0;
+	num_frames++;
+}
+
+void stats_sleep(long usec)
+{
+	sleep_accum += usec;
+}
+
+int stats_get(int which, struct stats_summary *res)
+{
+	int i;
+	long *sorted;
+	long sum = 0;
+	struct ring *r = ring + which;
+
+	memset(res, 0, sizeof *res);
+	if(!r->count) {
+		return -1;
+	}
+
+	if(!(sorted = malloc(r->count * sizeof *sorted))) {
+		return -1;
+	}
+	memcpy(sorted, r->samples, r->count * sizeof *sorted);
+	qsort(sorted, r->count, sizeof *sorted, cmp_long);
+
+	for(i=0; i<r->count; i++) {
+		sum += sorted[i];
+	}
+	res->count = r->count;
+	res->avg = sum / r->count;
+	res->max = sorted[r->count - 1];
+	res->p50 = sorted[(r->count - 1) * 50 / 100];
+	res->p95 = sorted[(r->count - 1) * 95 / 100];
+	res->p99 = sorted[(r->count - 1) * 99 / 100];
+
+	free(sorted);
+	return 0;
+}
+
+const char *stats_name(int which)
+{
+	return names[which];
+}
+
+unsigned long stats_frames(void)
+{
+	return num_frames;
+}
+
+unsigned long stats_dropped_frames(void)
+{
+	return sched_dropped_frames() - dropped_base;
+}
+
+long stats_last(int which)
+{
+	struct ring *r = ring + which;
+
+	if(!r->count) return -1;
+	return r->samples[(r->head + NUM_SAMPLES - 1) % NUM_SAMPLES];
+}
+
+static void add_sample(int which, long val)
+{
+	struct ring *r = ring + which;
+
+	r->samples[r->head] = val;
+	r->head = (r->head + 1) % NUM_SAMPLES;
+	if(r->count < NUM_SAMPLES) r->count++;
+}
+
+/* grab the results of any finished timer queries, without blocking */
+static void collect_queries(void)
+{
+	int i, avail;
+	uint64_t nsec;
+
+	for(i=0; i<NUM_QUERIES; i++) {
+		if(!query_pending[i]) continue;
+
+		xlivebg_gl_get_query_objectiv(query[i], GL_QUERY_RESULT_AVAILABLE, &avail);
+		if(avail) {
+			xlivebg_gl_get_query_objectui64v(query[i], GL_QUERY_RESULT, &nsec);
+			add_sample(STATS_GPU, (long)(nsec / 1000));
+			query_pending[i] = 0;
+		}
+	}
+}
+
+static int cmp_long(const void *a, const void *b)
+{
+	long x = *(long*)a;
+	long y = *(long*)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
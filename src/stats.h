@@ -0,0 +1,71 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <inttypes.h>
+
+/* per-frame timings kept by the stats module. All times in microseconds */
+enum {
+	STATS_INTERVAL,	/* time between the start of consecutive frames */
+	STATS_DRAW,		/* CPU time spent in the plugin draw function */
+	STATS_GPU,		/* GPU time for the frame (GL_TIME_ELAPSED), if available */
+	STATS_SWAP,		/* time spent in glXSwapBuffers/glFlush */
+	STATS_SLEEP,	/* time spent waiting for the next frame */
+
+	NUM_STATS
+};
+
+struct stats_summary {
+	int count;		/* number of samples in the window */
+	long avg, max;
+	long p50, p95, p99;
+};
+
+/* create/destroy the GPU timer queries, must be called with a current context */
+void stats_init_gl(void);
+void stats_destroy_gl(void);
+
+/* clears all collected samples and counters */
+void stats_reset(void);
+/* breaks the frame interval sequence, so that a pause (suspend) doesn't
+ * register as a very long frame.
+ */
+void stats_break(void);
+
+/* frame timing hooks, called from the main loop:
+ *   stats_frame_begin before drawing, stats_draw_done after the plugin draw
+ *   function returns, and stats_frame_end after the buffer swap.
+ */
+void stats_frame_begin(int64_t now);
+void stats_draw_done(int64_t now);
+void stats_frame_end(int64_t now);
+void stats_sleep(long usec);
+
+/* fills a summary of the last few hundred samples of the requested stat.
+ * Returns -1 if there are no samples.
+ */
+int stats_get(int which, struct stats_summary *res);
+const char *stats_name(int which);
+/* returns the most recent sample of the requested stat, or -1 if there are none */
+long stats_last(int which);
+
+unsigned long stats_frames(void);
+unsigned long stats_dropped_frames(void);
+
+#endif	/* STATS_H_ */
@@ -0,0 +1,197 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "opengl.h"
+#include "still.h"
+#include "app.h"
+#include "cfg.h"
+#include "layer.h"
+#include "swrender.h"
+#include "sched.h"
+
+/* while the output is detected static from the frame hashes, the pointer is
+ * polled this often (in microseconds), and a frame is drawn anyway every
+ * RECHECK_INTERVAL, to catch any change the plugin couldn't report.
+ */
+#define POINTER_POLL		50000
+#define RECHECK_INTERVAL	2000000
+
+static int is_static(void);
+static int detected_static(void);
+static uint32_t hash_frame(void);
+
+static int plugin_static;	/* declared by the plugin */
+static int dirty = 1;		/* something changed since the last frame */
+
+static uint32_t prev_hash;
+static int same_count;		/* consecutive frames hashing to prev_hash */
+static uint32_t *readback;
+static int readback_size;
+
+static int64_t next_pointer_poll, next_recheck;
+static int mouse_x, mouse_y;
+
+
+void still_reset(void)
+{
+	plugin_static = 0;
+	same_count = 0;
+	dirty = 1;
+}
+
+void still_set_static(int st)
+{
+	st = st ? 1 : 0;
+	if(st != plugin_static) {
+		plugin_static = st;
+		dirty = 1;
+		printf("xlivebg: output %s\n", st ? "static, drawing on changes only" : "animated");
+	}
+}
+
+int still_declared(void)
+{
+	return plugin_static;
+}
+
+void still_invalidate(void)
+{
+	dirty = 1;
+}
+
+long still_interval(long interval)
+{
+	return is_static() ? 0 : interval;
+}
+
+int still_skip(void)
+{
+	return is_static() && !dirty;
+}
+
+void still_update(int64_t now)
+{
+	int mx, my;
+
+	if(!detected_static() || dirty) return;
+
+	if(now >= next_pointer_poll) {
+		app_getmouse(&mx, &my);
+		if(mx != mouse_x || my != mouse_y) {
+			dirty = 1;
+		}
+		next_pointer_poll = now + POINTER_POLL;
+	}
+	if(now >= next_recheck) {
+		dirty = 1;
+	}
+}
+
+int64_t still_next_poll(void)
+{
+	if(!detected_static()) return -1;
+	return next_pointer_poll < next_recheck ? next_pointer_poll : next_recheck;
+}
+
+void still_frame(void)
+{
+	uint32_t hash;
+	int64_t now;
+
+	dirty = 0;
+
+	if(cfg.static_detect <= 0 || (plugin_static && !layer_count())) {
+		return;
+	}
+
+	hash = hash_frame();
+	if(hash == prev_hash) {
+		if(++same_count == cfg.static_detect) {
+			printf("xlivebg: no change in %d frames, drawing on changes only\n", cfg.static_detect);
+		}
+	} else {
+		prev_hash = hash;
+		same_count = 0;
+	}
+
+	if(detected_static()) {
+		now = sched_time_usec();
+		app_getmouse(&mouse_x, &mouse_y);
+		next_pointer_poll = now + POINTER_POLL;
+		next_recheck = now + RECHECK_INTERVAL;
+	}
+}
+
+/* declarations of the active plugin don't count while layers are stacked on
+ * top of it, only the hash of the whole frame does.
+ */
+static int is_static(void)
+{
+	if(plugin_static && !layer_count()) {
+		return 1;
+	}
+	return detected_static();
+}
+
+static int detected_static(void)
+{
+	return cfg.static_detect > 0 && same_count >= cfg.static_detect;
+}
+
+/* FNV-1a of the frame about to be presented */
+static uint32_t hash_frame(void)
+{
+	int i, size, stride, fbo = 0;
+	uint32_t *pixels, hash = 2166136261u;
+
+	if(sw_render) {
+		if(!(pixels = swr_framebuffer(&stride))) {
+			return 0;
+		}
+		size = stride * scr_height;
+	} else {
+		size = scr_width * scr_height;
+		if(size > readback_size) {
+			free(readback);
+			if(!(readback = malloc(size * sizeof *readback))) {
+				fprintf(stderr, "xlivebg: failed to allocate frame hash buffer\n");
+				readback_size = 0;
+				return 0;
+			}
+			readback_size = size;
+		}
+
+		if(xlivebg_gl_bind_framebuffer) {
+			glGetIntegerv(GL_FRAMEBUFFER_BINDING, &fbo);
+			if(fbo) xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, 0);
+		}
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glReadPixels(0, 0, scr_width, scr_height, GL_BGRA, GL_UNSIGNED_BYTE, readback);
+		if(fbo) {
+			xlivebg_gl_bind_framebuffer(GL_FRAMEBUFFER, fbo);
+		}
+		pixels = readback;
+	}
+
+	for(i=0; i<size; i++) {
+		hash = (hash ^ pixels[i]) * 16777619u;
+	}
+	return hash;
+}
@@ -0,0 +1,66 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef STILL_H_
+#define STILL_H_
+
+#include <inttypes.h>
+
+/* Static frame detection. A plugin whose output stops changing (because of
+ * its property values, or its content) declares it with xlivebg_set_static,
+ * and xlivebg stops drawing and presenting frames, and sleeps until something
+ * changes: a property, the active plugin, the outputs or the window, or
+ * drawing resumes after being suspended. For plugins which can't tell, every
+ * frame can be hashed instead, and the output is considered static after the
+ * number of identical frames in a row set by the static_detect option. With
+ * OpenGL that means reading back every frame, so it's off by default. Output
+ * found static that way is also redrawn when the pointer moves, and every
+ * couple of seconds, since the plugin may still change it on its own.
+ */
+
+/* forgets the state of the previous plugin, when a new one is activated */
+void still_reset(void);
+
+/* called by the active plugin to declare its output static, or not */
+void still_set_static(int st);
+/* returns what the plugin last declared with still_set_static */
+int still_declared(void);
+
+/* something changed, draw the next frame even if the output is static */
+void still_invalidate(void);
+
+/* returns the frame interval given the requested one: 0 (draw on events
+ * only) while the output is static.
+ */
+long still_interval(long interval);
+
+/* returns non-zero if the output is static and nothing changed since the
+ * last frame, so the next one can be skipped.
+ */
+int still_skip(void);
+
+/* polls the pointer, and checks if it's time to redraw a frame detected
+ * static, to see if it's still the same.
+ */
+void still_update(int64_t now);
+/* returns when still_update has to be called next, -1 if not needed */
+int64_t still_next_poll(void);
+
+/* called after drawing each frame, right before it's presented */
+void still_frame(void);
+
+#endif	/* STILL_H_ */
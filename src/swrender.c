@@ -0,0 +1,456 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <X11/Xutil.h>
+#ifdef HAVE_XSHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+#endif
+#include "swrender.h"
+#include "app.h"
+#include "cfg.h"
+
+/* swr_tiles splits the work into TILE_SIZE x TILE_SIZE pixel tiles */
+#define TILE_SIZE	64
+#define MAX_THREADS	64
+
+struct job {
+	xlivebg_tile_func func;
+	void *cls;
+	uint32_t *pixels;
+	int stride, width, height;
+	int xtiles, num_tiles;
+	int next, pending;		/* next tile to hand out, and tiles not done yet */
+};
+
+static int create_image(int width, int height);
+static void destroy_image(void);
+#ifdef HAVE_XSHM
+static XImage *create_shm_image(int width, int height);
+static int trap_handler(Display *dpy, XErrorEvent *ev);
+#endif
+static void *alloc_pixels(size_t size);
+static void free_pixels(void *pixels);
+
+static void start_workers(int count);
+static void stop_workers(void);
+static void *worker(void *cls);
+static int run_tile(void);
+
+static Display *dpy;
+static Window win;
+static GC gc;
+static Visual *visual;
+static int depth;
+static XImage *ximg;
+static int use_shm;
+#ifdef HAVE_XSHM
+static XShmSegmentInfo shm;
+static int xerr;
+#endif
+
+static uint32_t *fb;
+static int fb_width, fb_height, fb_stride;
+static size_t pix_size;	/* size of the mapping returned by alloc_pixels */
+
+static pthread_t workers[MAX_THREADS];
+static int num_workers, pool_size;
+static int quit_workers;
+static pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+static struct job job;
+
+
+int swr_init(Display *d, Window w, int width, int height)
+{
+	XWindowAttributes wattr;
+
+	dpy = d;
+	win = w;
+
+	if(win) {
+		XGetWindowAttributes(dpy, win, &wattr);
+		visual = wattr.visual;
+		depth = wattr.depth;
+
+		if(visual->class != TrueColor || (depth != 24 && depth != 32) ||
+				visual->red_mask != 0xff0000 || visual->green_mask != 0xff00 ||
+				visual->blue_mask != 0xff) {
+			fprintf(stderr, "swrender: window visual isn't 24bit xRGB TrueColor\n");
+			return -1;
+		}
+
+		gc = XCreateGC(dpy, win, 0, 0);
+#ifdef HAVE_XSHM
+		use_shm = XShmQueryExtension(dpy);
+#endif
+	}
+
+	if(swr_resize(width, height) == -1) {
+		if(gc) {
+			XFreeGC(dpy, gc);
+			gc = 0;
+		}
+		return -1;
+	}
+
+	printf("software rendering: %s\n", win ? (use_shm ? "MIT-SHM" : "XPutImage") : "offscreen");
+	return 0;
+}
+
+void swr_destroy(void)
+{
+	stop_workers();
+	destroy_image();
+	if(gc) {
+		XFreeGC(dpy, gc);
+		gc = 0;
+	}
+}
+
+int swr_resize(int width, int height)
+{
+	if(fb && width == fb_width && height == fb_height) {
+		return 0;
+	}
+	destroy_image();
+
+	if(win) {
+		if(create_image(width, height) == -1) {
+			return -1;
+		}
+		fb = (uint32_t*)ximg->data;
+		fb_stride = ximg->bytes_per_line / 4;
+	} else {
+		if(!(fb = alloc_pixels(width * height * sizeof *fb))) {
+			fprintf(stderr, "swrender: failed to allocate %dx%d framebuffer\n", width, height);
+			return -1;
+		}
+		fb_stride = width;
+	}
+	fb_width = width;
+	fb_height = height;
+
+	memset(fb, 0, fb_stride * fb_height * sizeof *fb);
+	return 0;
+}
+
+uint32_t *swr_framebuffer(int *stride)
+{
+	*stride = fb_stride;
+	return fb;
+}
+
+/* presents only the visible screens, skipping outputs covered by fullscreen
+ * windows.
+ */
+void swr_present(void)
+{
+	int i, x, y, w, h;
+	struct xlivebg_screen *scr;
+
+	if(!ximg) return;
+
+	for(i=0; i<num_vis_screens; i++) {
+		scr = screen + vis_screen[i];
+		x = scr->x;
+		y = scr->y;
+		w = scr->width;
+		h = scr->height;
+		if(x + w > fb_width) w = fb_width - x;
+		if(y + h > fb_height) h = fb_height - y;
+		if(w <= 0 || h <= 0) continue;
+
+#ifdef HAVE_XSHM
+		if(use_shm) {
+			XShmPutImage(dpy, win, gc, ximg, x, y, x, y, w, h, False);
+			continue;
+		}
+#endif
+		XPutImage(dpy, win, gc, ximg, x, y, x, y, w, h);
+	}
+
+	/* wait for the X server to read the framebuffer, before the next frame is
+	 * drawn over it.
+	 */
+	XSync(dpy, False);
+}
+
+static int create_image(int width, int height)
+{
+#ifdef HAVE_XSHM
+	if(use_shm) {
+		if((ximg = create_shm_image(width, height))) {
+			return 0;
+		}
+		fprintf(stderr, "swrender: failed to create shared memory image, falling back to XPutImage\n");
+		use_shm = 0;
+	}
+#endif
+
+	if(!(ximg = XCreateImage(dpy, visual, depth, ZPixmap, 0, 0, width, height, 32, 0))) {
+		fprintf(stderr, "swrender: failed to create %dx%d image\n", width, height);
+		return -1;
+	}
+	if(ximg->bits_per_pixel != 32) {
+		fprintf(stderr, "swrender: unsupported image format: %d bits per pixel\n", ximg->bits_per_pixel);
+		XDestroyImage(ximg);
+		ximg = 0;
+		return -1;
+	}
+	if(!(ximg->data = alloc_pixels(ximg->bytes_per_line * height))) {
+		fprintf(stderr, "swrender: failed to allocate %dx%d framebuffer\n", width, height);
+		XDestroyImage(ximg);
+		ximg = 0;
+		return -1;
+	}
+	return 0;
+}
+
+static void destroy_image(void)
+{
+	if(ximg) {
+#ifdef HAVE_XSHM
+		if(use_shm) {
+			XShmDetach(dpy, &shm);
+			XSync(dpy, False);
+			XDestroyImage(ximg);
+			shmdt(shm.shmaddr);
+			ximg = 0;
+		}
+#endif
+		if(ximg) {
+			free_pixels(ximg->data);
+			ximg->data = 0;
+			XDestroyImage(ximg);
+			ximg = 0;
+		}
+	} else {
+		free_pixels(fb);
+	}
+	fb = 0;
+	fb_width = fb_height = 0;
+}
+
+/* framebuffers outside of MIT-SHM segments are mapped shared too, so that
+ * isolated plugin host processes (see host.h) can draw into them.
+ */
+static void *alloc_pixels(size_t size)
+{
+	void *pixels;
+
+	pixels = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(pixels == MAP_FAILED) {
+		return 0;
+	}
+	pix_size = size;
+	return pixels;
+}
+
+static void free_pixels(void *pixels)
+{
+	if(pixels) {
+		munmap(pixels, pix_size);
+	}
+}
+
+#ifdef HAVE_XSHM
+static XImage *create_shm_image(int width, int height)
+{
+	XImage *img;
+	int (*prev_handler)(Display*, XErrorEvent*);
+
+	if(!(img = XShmCreateImage(dpy, visual, depth, ZPixmap, 0, &shm, width, height))) {
+		return 0;
+	}
+	if(img->bits_per_pixel != 32) {
+		XDestroyImage(img);
+		return 0;
+	}
+
+	if((shm.shmid = shmget(IPC_PRIVATE, img->bytes_per_line * height, IPC_CREAT | 0600)) == -1) {
+		XDestroyImage(img);
+		return 0;
+	}
+	if((shm.shmaddr = img->data = shmat(shm.shmid, 0, 0)) == (void*)-1) {
+		shmctl(shm.shmid, IPC_RMID, 0);
+		XDestroyImage(img);
+		return 0;
+	}
+	shm.readOnly = False;
+
+	/* attaching fails (asynchronously) if the X server isn't on this machine */
+	XSync(dpy, False);
+	xerr = 0;
+	prev_handler = XSetErrorHandler(trap_handler);
+	XShmAttach(dpy, &shm);
+	XSync(dpy, False);
+	XSetErrorHandler(prev_handler);
+
+	/* mark the segment for removal, it goes away when both sides detach */
+	shmctl(shm.shmid, IPC_RMID, 0);
+
+	if(xerr) {
+		shmdt(shm.shmaddr);
+		XDestroyImage(img);
+		return 0;
+	}
+	return img;
+}
+
+static int trap_handler(Display *dpy, XErrorEvent *ev)
+{
+	xerr = ev->error_code;
+	return 0;
+}
+#endif	/* HAVE_XSHM */
+
+void swr_tiles(uint32_t *pixels, int stride, int width, int height,
+		xlivebg_tile_func func, void *cls)
+{
+	int count;
+
+	if(width <= 0 || height <= 0) return;
+
+	/* the worker pool is (re)started whenever the thread count changes */
+	if((count = cfg.sw_threads) <= 0) {
+		count = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if(count < 1) count = 1;
+	if(count > MAX_THREADS) count = MAX_THREADS;
+
+	if(count != pool_size) {
+		stop_workers();
+		start_workers(count - 1);
+		pool_size = count;
+	}
+
+	pthread_mutex_lock(&job_lock);
+	job.func = func;
+	job.cls = cls;
+	job.pixels = pixels;
+	job.stride = stride;
+	job.width = width;
+	job.height = height;
+	job.xtiles = (width + TILE_SIZE - 1) / TILE_SIZE;
+	job.num_tiles = job.xtiles * ((height + TILE_SIZE - 1) / TILE_SIZE);
+	job.next = 0;
+	job.pending = job.num_tiles;
+	pthread_cond_broadcast(&job_cond);
+
+	/* the calling thread works on tiles too, then waits for the rest */
+	while(run_tile());
+	while(job.pending > 0) {
+		pthread_cond_wait(&done_cond, &job_lock);
+	}
+	pthread_mutex_unlock(&job_lock);
+}
+
+/* threads don't survive fork, so the host process starts its own pool */
+void swr_after_fork(void)
+{
+	num_workers = pool_size = 0;
+	quit_workers = 0;
+	pthread_mutex_init(&job_lock, 0);
+	pthread_cond_init(&job_cond, 0);
+	pthread_cond_init(&done_cond, 0);
+}
+
+static void start_workers(int count)
+{
+	int i;
+
+	quit_workers = 0;
+	for(i=0; i<count; i++) {
+		if(pthread_create(workers + i, 0, worker, 0) != 0) {
+			fprintf(stderr, "swrender: failed to create worker thread\n");
+			break;
+		}
+	}
+	num_workers = i;
+	printf("software rendering threads: %d\n", num_workers + 1);
+}
+
+static void stop_workers(void)
+{
+	int i;
+
+	pthread_mutex_lock(&job_lock);
+	quit_workers = 1;
+	pthread_cond_broadcast(&job_cond);
+	pthread_mutex_unlock(&job_lock);
+
+	for(i=0; i<num_workers; i++) {
+		pthread_join(workers[i], 0);
+	}
+	num_workers = 0;
+	pool_size = 0;
+}
+
+static void *worker(void *cls)
+{
+	pthread_mutex_lock(&job_lock);
+	while(!quit_workers) {
+		if(!run_tile()) {
+			pthread_cond_wait(&job_cond, &job_lock);
+		}
+	}
+	pthread_mutex_unlock(&job_lock);
+	return 0;
+}
+
+/* runs the next tile of the current job, if there are any left. Must be called
+ * with job_lock held, which is released while the tile is drawn.
+ */
+static int run_tile(void)
+{
+	int idx, x, y, w, h, stride;
+	xlivebg_tile_func func;
+	void *cls;
+	uint32_t *pixels;
+
+	if(job.next >= job.num_tiles) {
+		return 0;
+	}
+	idx = job.next++;
+
+	x = (idx % job.xtiles) * TILE_SIZE;
+	y = (idx / job.xtiles) * TILE_SIZE;
+	w = job.width - x < TILE_SIZE ? job.width - x : TILE_SIZE;
+	h = job.height - y < TILE_SIZE ? job.height - y : TILE_SIZE;
+	stride = job.stride;
+	pixels = job.pixels + y * stride + x;
+	func = job.func;
+	cls = job.cls;
+
+	pthread_mutex_unlock(&job_lock);
+	func(pixels, stride, x, y, w, h, cls);
+	pthread_mutex_lock(&job_lock);
+
+	if(--job.pending <= 0) {
+		pthread_cond_signal(&done_cond);
+	}
+	return 1;
+}
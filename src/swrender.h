@@ -0,0 +1,51 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef SWRENDER_H_
+#define SWRENDER_H_
+
+#include <X11/Xlib.h>
+#include "xlivebg.h"
+
+/* Software rendering backend, for machines without a usable OpenGL
+ * implementation. Plugins with a draw_sw function draw into a 32bit CPU
+ * framebuffer, which is presented with XShmPutImage (or plain XPutImage if
+ * the MIT-SHM extension isn't available). Pixels are 0xXXRRGGBB.
+ */
+
+/* creates the framebuffer for drawing on win. If win is 0 the framebuffer is
+ * kept in memory, and never presented (benchmark mode).
+ */
+int swr_init(Display *dpy, Window win, int width, int height);
+void swr_destroy(void);
+int swr_resize(int width, int height);
+
+/* returns the framebuffer, and its stride in pixels */
+uint32_t *swr_framebuffer(int *stride);
+void swr_present(void);
+
+/* splits a rectangle of width x height pixels starting at pixels into tiles,
+ * and calls func for each one, from a pool of worker threads. Returns when all
+ * tiles are done.
+ */
+void swr_tiles(uint32_t *pixels, int stride, int width, int height,
+		xlivebg_tile_func func, void *cls);
+
+/* resets the worker pool state in a forked child process */
+void swr_after_fork(void);
+
+#endif	/* SWRENDER_H_ */
@@ -0,0 +1,168 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "timesrc.h"
+#include "sched.h"
+
+/* step used by the fixed clock when it's not specified, and there's no frame
+ * interval to go by
+ */
+#define DEF_STEP	(1000000 / 60)
+
+static int mode = TIMESRC_REAL;
+static long step;		/* fixed step in usec, 0 to follow the frame interval */
+static double scale = 1.0;
+
+static int64_t anim_time, prev_frame;
+static int first_frame = 1;
+static int paused;
+
+
+int timesrc_set(const char *str)
+{
+	char *endp;
+	long lval;
+	double dval;
+
+	if(strcmp(str, "real") == 0) {
+		mode = TIMESRC_REAL;
+		return 0;
+	}
+	if(strcmp(str, "fixed") == 0) {
+		mode = TIMESRC_FIXED;
+		step = 0;
+		return 0;
+	}
+	if(memcmp(str, "fixed:", 6) == 0) {
+		lval = strtol(str + 6, &endp, 10);
+		if(endp == str + 6 || *endp || lval <= 0) {
+			fprintf(stderr, "invalid fixed time step: %s\n", str + 6);
+			return -1;
+		}
+		mode = TIMESRC_FIXED;
+		step = lval;
+		return 0;
+	}
+	if(memcmp(str, "scale:", 6) == 0) {
+		dval = strtod(str + 6, &endp);
+		if(endp == str + 6 || *endp || dval < 0.0) {
+			fprintf(stderr, "invalid time scale: %s\n", str + 6);
+			return -1;
+		}
+		mode = TIMESRC_SCALED;
+		scale = dval;
+		return 0;
+	}
+
+	fprintf(stderr, "invalid time source: %s\n", str);
+	return -1;
+}
+
+void timesrc_describe(char *buf, int bufsz)
+{
+	switch(mode) {
+	case TIMESRC_FIXED:
+		if(step > 0) {
+			snprintf(buf, bufsz, "fixed:%ld", step);
+		} else {
+			snprintf(buf, bufsz, "fixed");
+		}
+		break;
+
+	case TIMESRC_SCALED:
+		snprintf(buf, bufsz, "scale:%g", scale);
+		break;
+
+	default:
+		snprintf(buf, bufsz, "real");
+	}
+}
+
+int timesrc_mode(void)
+{
+	return mode;
+}
+
+void timesrc_reset(int64_t now)
+{
+	anim_time = 0;
+	prev_frame = now;
+	first_frame = 1;
+}
+
+int64_t timesrc_frame(int64_t now)
+{
+	long dt;
+
+	if(paused) {
+		return anim_time;
+	}
+
+	if(first_frame) {
+		first_frame = 0;
+		prev_frame = now;
+		return anim_time;
+	}
+
+	/* all modes accumulate per-frame deltas, so that switching between
+	 * them, or changing the scale, is seamless.
+	 */
+	switch(mode) {
+	case TIMESRC_FIXED:
+		if(step > 0) {
+			dt = step;
+		} else {
+			dt = sched_interval() > 0 ? sched_interval() : DEF_STEP;
+		}
+		break;
+
+	case TIMESRC_SCALED:
+		dt = (long)((now - prev_frame) * scale);
+		break;
+
+	default:
+		dt = now - prev_frame;
+	}
+	prev_frame = now;
+
+	anim_time += dt;
+	return anim_time;
+}
+
+void timesrc_pause(int64_t now)
+{
+	if(paused) return;
+
+	/* account for the time between the last frame and the pause, the fixed
+	 * clock only advances when frames are drawn.
+	 */
+	if(mode != TIMESRC_FIXED) {
+		timesrc_frame(now);
+	}
+	paused = 1;
+}
+
+void timesrc_resume(int64_t now)
+{
+	if(!paused) return;
+
+	paused = 0;
+	prev_frame = now;
+}
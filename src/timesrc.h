@@ -0,0 +1,55 @@
+/*
+xlivebg - live wallpapers for the X window system
+Copyright (C) 2019-2020  John Tsiombikas <nuclear@member.fsf.org>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef TIMESRC_H_
+#define TIMESRC_H_
+
+#include <inttypes.h>
+
+/* animation time sources */
+enum {
+	TIMESRC_REAL,	/* monotonic clock, excluding time spent suspended */
+	TIMESRC_FIXED,	/* advances by a fixed step every frame, regardless of wall time */
+	TIMESRC_SCALED	/* monotonic clock, sped up or slowed down by a factor */
+};
+
+/* parses a time source description and makes it current. Accepted forms:
+ *   "real", "fixed" (step = frame interval), "fixed:<usec>", "scale:<factor>"
+ * Switching time sources doesn't cause a jump in animation time.
+ * Returns -1 on invalid input.
+ */
+int timesrc_set(const char *str);
+/* writes a description of the current time source, in the form accepted by
+ * timesrc_set
+ */
+void timesrc_describe(char *buf, int bufsz);
+
+int timesrc_mode(void);
+
+/* restarts animation time at 0 */
+void timesrc_reset(int64_t now);
+
+/* advances the clock for a new frame, and returns the animation time in
+ * microseconds. Called exactly once per drawn frame.
+ */
+int64_t timesrc_frame(int64_t now);
+
+/* stop/restart the clock while drawing is suspended */
+void timesrc_pause(int64_t now);
+void timesrc_resume(int64_t now);
+
+#endif	/* TIMESRC_H_ */